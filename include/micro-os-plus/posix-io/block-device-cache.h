@@ -0,0 +1,914 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_CACHE_H_
+#define MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_CACHE_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/block-device.h>
+
+#include <micro-os-plus/utils/lists.h>
+
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    class block_device_cache_impl;
+
+    // ========================================================================
+
+    /**
+     * @brief Block device buffer cache class.
+     * @headerfile block-device-cache.h
+     * <micro-os-plus/posix-io/block-device-cache.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * A block device which keeps recently used blocks of another
+     * block device in RAM, so file system metadata (FAT sectors,
+     * directories) is not re-read from the media on each access.
+     *
+     * Writes are delayed until the block is evicted or the device
+     * is synchronised; `sync()` and `close()` write back all
+     * dirty blocks.
+     */
+    class block_device_cache : public block_device
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      block_device_cache (block_device_impl& impl, const char* name);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_cache (const block_device_cache&) = delete;
+      block_device_cache (block_device_cache&&) = delete;
+      block_device_cache&
+      operator= (const block_device_cache&)
+          = delete;
+      block_device_cache&
+      operator= (block_device_cache&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_cache ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      std::size_t
+      hits (void) const;
+
+      std::size_t
+      misses (void) const;
+
+      // ----------------------------------------------------------------------
+      // Support functions.
+
+      block_device_cache_impl&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+    };
+
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @details
+     * The replacement policy is 2Q (Johnson & Shasha): blocks seen
+     * once enter a small FIFO queue, and only blocks referenced
+     * again, while still remembered in the ghost queue, are
+     * promoted to the main LRU queue. A long sequential scan thus
+     * only cycles through the FIFO, without flushing the hot
+     * metadata from the main queue.
+     */
+    class block_device_cache_impl : public block_device_impl
+    {
+      // ----------------------------------------------------------------------
+
+      friend block_device_cache;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      block_device_cache_impl (block_device& parent, std::size_t buffers);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_cache_impl (const block_device_cache_impl&) = delete;
+      block_device_cache_impl (block_device_cache_impl&&) = delete;
+      block_device_cache_impl&
+      operator= (const block_device_cache_impl&)
+          = delete;
+      block_device_cache_impl&
+      operator= (block_device_cache_impl&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_cache_impl () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      virtual int
+      do_vioctl (int request, std::va_list arguments) override;
+
+      virtual int
+      do_vopen (const char* path, int oflag, std::va_list arguments) override;
+
+      virtual ssize_t
+      do_read_block (void* buf, blknum_t blknum, std::size_t nblocks) override;
+
+      virtual ssize_t
+      do_write_block (const void* buf, blknum_t blknum,
+                      std::size_t nblocks) override;
+
+      virtual int
+      do_discard (blknum_t blknum, std::size_t nblocks, bool secure) override;
+
+      virtual int
+      do_write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual void
+      do_sync (void) override;
+
+      virtual int
+      do_close (void) override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      enum class queue : std::uint8_t
+      {
+        none,
+        in, // Seen once, FIFO.
+        main // Seen again, LRU.
+      };
+
+      struct buffer
+      {
+        // In one of the free, in or main lists.
+        utils::double_list_links links;
+
+        buffer* hash_next;
+        blknum_t blknum;
+        std::uint8_t* data;
+        queue where;
+        bool dirty;
+      };
+
+      using buffer_list = utils::intrusive_list<buffer, utils::double_list_links,
+                                                &buffer::links>;
+
+      buffer*
+      find (blknum_t blknum);
+
+      // Get a buffer for the block, evicting one if needed; nullptr
+      // if the evicted block cannot be written back.
+      buffer*
+      allocate (blknum_t blknum);
+
+      void
+      touch (buffer* b);
+
+      int
+      write_back (buffer* b);
+
+      // Write back all dirty blocks.
+      int
+      flush (void);
+
+      // Forget all blocks; dirty blocks are lost.
+      void
+      invalidate (void);
+
+      // Forget the blocks in the range, dirty or not.
+      void
+      drop (blknum_t blknum, std::size_t nblocks);
+
+      void
+      remember (blknum_t blknum);
+
+      bool
+      forget (blknum_t blknum);
+
+      // ----------------------------------------------------------------------
+
+      block_device& parent_;
+
+      std::size_t buffers_count_;
+      // Maximum number of blocks in the in queue (25%).
+      std::size_t in_max_;
+      // Maximum number of remembered evicted blocks (50%).
+      std::size_t ghosts_max_;
+
+      buffer* buffers_ = nullptr;
+      std::uint8_t* data_ = nullptr;
+      std::size_t data_block_size_ = 0;
+
+      buffer** buckets_ = nullptr;
+      std::size_t buckets_mask_ = 0;
+
+      buffer_list free_list_;
+      buffer_list in_list_;
+      buffer_list main_list_;
+      std::size_t in_count_ = 0;
+
+      // Ring of the block numbers recently evicted from the in queue.
+      blknum_t* ghosts_ = nullptr;
+      std::size_t ghosts_head_ = 0;
+      std::size_t ghosts_count_ = 0;
+
+      std::size_t hits_ = 0;
+      std::size_t misses_ = 0;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ========================================================================
+
+    template <typename T = block_device_cache_impl>
+    class block_device_cache_implementable : public block_device_cache
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      using value_type = T;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      template <typename... Args>
+      block_device_cache_implementable (const char* name, block_device& parent,
+                                        Args&&... arguments);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_cache_implementable (
+          const block_device_cache_implementable&)
+          = delete;
+      block_device_cache_implementable (block_device_cache_implementable&&)
+          = delete;
+      block_device_cache_implementable&
+      operator= (const block_device_cache_implementable&)
+          = delete;
+      block_device_cache_implementable&
+      operator= (block_device_cache_implementable&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_cache_implementable ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Support functions.
+
+      value_type&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Include the implementation as a member.
+      value_type impl_instance_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
+    template <typename T, typename L>
+    class block_device_cache_lockable : public block_device_cache
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      using value_type = T;
+      using lockable_type = L;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      template <typename... Args>
+      block_device_cache_lockable (const char* name, block_device& parent,
+                                   lockable_type& locker, Args&&... arguments);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_cache_lockable (const block_device_cache_lockable&)
+          = delete;
+      block_device_cache_lockable (block_device_cache_lockable&&) = delete;
+      block_device_cache_lockable&
+      operator= (const block_device_cache_lockable&)
+          = delete;
+      block_device_cache_lockable&
+      operator= (block_device_cache_lockable&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_cache_lockable () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      virtual int
+      close (void) override;
+
+      virtual ssize_t
+      read (void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      write (const void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      readv (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      writev (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual int
+      vfcntl (int cmd, std::va_list arguments) override;
+
+      virtual int
+      vioctl (int request, std::va_list arguments) override;
+
+      virtual off_t
+      lseek (off_t offset, int whence) override;
+
+      virtual ssize_t
+      read_block (void* buf, blknum_t blknum,
+                  std::size_t nblocks = 1) override;
+
+      virtual ssize_t
+      write_block (const void* buf, blknum_t blknum,
+                   std::size_t nblocks = 1) override;
+
+      virtual int
+      submit_block (block_request& request) override;
+
+      virtual int
+      discard_blocks (blknum_t blknum, std::size_t nblocks,
+                      bool secure = false) override;
+
+      virtual int
+      write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual void
+      sync (void) override;
+
+      virtual bool
+      is_lockable (void) const override;
+
+      virtual const void*
+      lock_domain (void) const override;
+
+      // ----------------------------------------------------------------------
+      // Support functions.
+
+      value_type&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Include the implementation as a member.
+      value_type impl_instance_;
+
+      lockable_type& locker_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    inline std::size_t
+    block_device_cache::hits (void) const
+    {
+      return impl ().hits_;
+    }
+
+    inline std::size_t
+    block_device_cache::misses (void) const
+    {
+      return impl ().misses_;
+    }
+
+    inline block_device_cache_impl&
+    block_device_cache::impl (void) const
+    {
+      return static_cast<block_device_cache_impl&> (impl_);
+    }
+
+    // ========================================================================
+
+    template <typename T>
+    template <typename... Args>
+    block_device_cache_implementable<T>::block_device_cache_implementable (
+        const char* name, block_device& parent, Args&&... arguments)
+        : block_device_cache{ impl_instance_, name }, //
+          impl_instance_{ parent, std::forward<Args> (arguments)... }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_implementable::%s(\"%s\")=@%p\n",
+                     __func__, name_, this);
+#endif
+    }
+
+    template <typename T>
+    block_device_cache_implementable<T>::~block_device_cache_implementable ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_implementable::%s() @%p %s\n",
+                     __func__, this, name_);
+#endif
+    }
+
+    template <typename T>
+    typename block_device_cache_implementable<T>::value_type&
+    block_device_cache_implementable<T>::impl (void) const
+    {
+      return static_cast<value_type&> (impl_);
+    }
+
+    // ========================================================================
+
+    template <typename T, typename L>
+    template <typename... Args>
+    block_device_cache_lockable<T, L>::block_device_cache_lockable (
+        const char* name, block_device& parent, lockable_type& locker,
+        Args&&... arguments)
+        : block_device_cache{ impl_instance_, name }, //
+          impl_instance_{ parent, std::forward<Args> (arguments)... }, //
+          locker_ (locker)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(\"%s\")=@%p\n",
+                     __func__, name_, this);
+#endif
+    }
+
+    template <typename T, typename L>
+    block_device_cache_lockable<T, L>::~block_device_cache_lockable ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s() @%p %s\n", __func__,
+                     this, name_);
+#endif
+    }
+
+    // ------------------------------------------------------------------------
+
+    template <typename T, typename L>
+    int
+    block_device_cache_lockable<T, L>::close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s() @%p\n", __func__,
+                     this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::close ();
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::read (void* buf, std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(0x0%X, %u) @%p\n",
+                     __func__, buf, nbyte, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::read (buf, nbyte);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::write (const void* buf,
+                                              std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(0x0%X, %u) @%p\n",
+                     __func__, buf, nbyte, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::write (buf, nbyte);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::readv (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(0x0%X, %d) @%p\n",
+                     __func__, iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::readv (iov, iovcnt);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::writev (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(0x0%X, %d) @%p\n",
+                     __func__, iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::writev (iov, iovcnt);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::pread (void* buf, std::size_t nbyte,
+                                              off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(0x0%X, %u, %d) @%p\n",
+                     __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::pread (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::pwrite (const void* buf,
+                                               std::size_t nbyte,
+                                               off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(0x0%X, %u, %d) @%p\n",
+                     __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::pwrite (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_cache_lockable<T, L>::vfcntl (int cmd,
+                                               std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%d) @%p\n", __func__,
+                     cmd, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::vfcntl (cmd, arguments);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_cache_lockable<T, L>::vioctl (int request,
+                                               std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%d) @%p\n", __func__,
+                     request, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::vioctl (request, arguments);
+    }
+
+    template <typename T, typename L>
+    off_t
+    block_device_cache_lockable<T, L>::lseek (off_t offset, int whence)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%d, %d) @%p\n",
+                     __func__, offset, whence, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::lseek (offset, whence);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::read_block (void* buf, blknum_t blknum,
+                                                   std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%p, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::read_block (buf, blknum, nblocks);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_cache_lockable<T, L>::write_block (const void* buf,
+                                                    blknum_t blknum,
+                                                    std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%p, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::write_block (buf, blknum, nblocks);
+    }
+
+    /**
+     * @details
+     * The lock is held only while the request is started, not
+     * until it completes.
+     */
+    template <typename T, typename L>
+    int
+    block_device_cache_lockable<T, L>::submit_block (block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%p) @%p\n", __func__,
+                     &request, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::submit_block (request);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_cache_lockable<T, L>::discard_blocks (blknum_t blknum,
+                                                       std::size_t nblocks,
+                                                       bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%u, %u, %d) @%p\n",
+                     __func__, blknum, nblocks, secure, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::discard_blocks (blknum, nblocks, secure);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_cache_lockable<T, L>::write_zeroes (blknum_t blknum,
+                                                     std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s(%u, %u) @%p\n",
+                     __func__, blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::write_zeroes (blknum, nblocks);
+    }
+
+    template <typename T, typename L>
+    void
+    block_device_cache_lockable<T, L>::sync (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_lockable::%s() @%p\n", __func__,
+                     this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_cache::sync ();
+    }
+
+    template <typename T, typename L>
+    bool
+    block_device_cache_lockable<T, L>::is_lockable (void) const
+    {
+      return true;
+    }
+
+    template <typename T, typename L>
+    const void*
+    block_device_cache_lockable<T, L>::lock_domain (void) const
+    {
+      return &locker_;
+    }
+
+    template <typename T, typename L>
+    typename block_device_cache_lockable<T, L>::value_type&
+    block_device_cache_lockable<T, L>::impl (void) const
+    {
+      return static_cast<value_type&> (impl_);
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_CACHE_H_
+
+// ----------------------------------------------------------------------------
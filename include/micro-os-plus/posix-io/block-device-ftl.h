@@ -0,0 +1,1050 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_FTL_H_
+#define MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_FTL_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/block-device.h>
+
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+// When the erase counts of the data blocks differ by more than this,
+// the collector moves the coldest block (static wear levelling).
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_FTL_WEAR_THRESHOLD)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_FTL_WEAR_THRESHOLD (64)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    class block_device_ftl_impl;
+
+    // ========================================================================
+
+    /**
+     * @brief Flash translation layer block device class.
+     * @headerfile block-device-ftl.h
+     * <micro-os-plus/posix-io/block-device-ftl.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * A block device with rewritable blocks, built on top of a raw
+     * flash device, which can only program erased pages and erase
+     * whole blocks.
+     *
+     * The parent logical block is the program page, and the parent
+     * physical block is the erase block; the parent `do_discard()`
+     * must erase the range (always whole erase blocks) to all ones.
+     * Erases are read back, and a parent which takes discards only
+     * as hints fails them with `EIO`.
+     *
+     * A parent without a valid journal is formatted at open only
+     * if blank; otherwise the open fails with `EIO`. Opening with
+     * `O_TRUNC` formats it anyway.
+     *
+     * Each write programs the next free page, and only the map
+     * in RAM is updated; the old copy becomes garbage, reclaimed
+     * later by the collector, so a small write costs a page
+     * program, not an erase.
+     *
+     * Writes become persistent after `sync()` or `close()`; after
+     * a power failure, the device returns to the state of the last
+     * synchronisation.
+     */
+    class block_device_ftl : public block_device
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      block_device_ftl (block_device_impl& impl, const char* name);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_ftl (const block_device_ftl&) = delete;
+      block_device_ftl (block_device_ftl&&) = delete;
+      block_device_ftl&
+      operator= (const block_device_ftl&)
+          = delete;
+      block_device_ftl&
+      operator= (block_device_ftl&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_ftl ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Reclaim one erase block, if worth it; to be called from a low
+      // priority thread, so writes seldom have to wait for erases.
+      // Return 1 if a block was reclaimed, 0 if there was nothing to
+      // do, or -1 with errno.
+      virtual int
+      collect (void);
+
+      // The number of erases since opened.
+      std::size_t
+      erases (void) const;
+
+      // ----------------------------------------------------------------------
+      // Support functions.
+
+      block_device_ftl_impl&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+    };
+
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @details
+     * The first erase blocks hold two journal areas, used in turns;
+     * the rest hold the data. Out of the data blocks, `spare` are
+     * not exported, so the collector always finds blocks with
+     * garbage to reclaim.
+     *
+     * The map changes are appended to the journal, one page of
+     * entries at a time. When the area fills, the other one is
+     * erased and a snapshot of the map and of the erase counts is
+     * written there; an area is used at mount only if its snapshot
+     * is complete, so the old one remains valid until then.
+     * The journal is always written before a data block is erased,
+     * so the recorded map never points to erased pages.
+     *
+     * Free blocks are allocated least worn first (dynamic wear
+     * levelling); the collector reclaims the block with the fewest
+     * valid pages, or, when the erase counts drift too far apart,
+     * the least worn block, whose cold data pins it down (static
+     * wear levelling).
+     */
+    class block_device_ftl_impl : public block_device_impl
+    {
+      // ----------------------------------------------------------------------
+
+      friend block_device_ftl;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      block_device_ftl_impl (block_device& parent, std::size_t spare);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_ftl_impl (const block_device_ftl_impl&) = delete;
+      block_device_ftl_impl (block_device_ftl_impl&&) = delete;
+      block_device_ftl_impl&
+      operator= (const block_device_ftl_impl&)
+          = delete;
+      block_device_ftl_impl&
+      operator= (block_device_ftl_impl&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_ftl_impl () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      virtual int
+      do_vioctl (int request, std::va_list arguments) override;
+
+      virtual int
+      do_vopen (const char* path, int oflag, std::va_list arguments) override;
+
+      virtual ssize_t
+      do_read_block (void* buf, blknum_t blknum, std::size_t nblocks) override;
+
+      virtual ssize_t
+      do_write_block (const void* buf, blknum_t blknum,
+                      std::size_t nblocks) override;
+
+      virtual int
+      do_discard (blknum_t blknum, std::size_t nblocks, bool secure) override;
+
+      virtual int
+      do_write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual void
+      do_sync (void) override;
+
+      virtual int
+      do_close (void) override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Data erase block index.
+      using block_t = std::size_t;
+
+      enum class state : std::uint8_t
+      {
+        free, // Erased.
+        used,
+        current // Being filled.
+      };
+
+      struct journal_header
+      {
+        std::uint32_t magic;
+        std::uint32_t seq;
+        std::uint16_t flags;
+        std::uint16_t count;
+        std::uint32_t crc;
+      };
+
+      static constexpr std::uint32_t none__ = 0xFFFFFFFF;
+      static constexpr std::uint32_t journal_magic__ = 0x4C54464A;
+      // Entries with this bit in the key hold erase counts.
+      static constexpr std::uint32_t erase_count_key__ = 0x80000000;
+      static constexpr std::uint16_t snapshot_flag__ = 1;
+      static constexpr std::uint16_t end_flag__ = 2;
+      // Free blocks kept for the collector.
+      static constexpr std::size_t reserve__ = 1;
+      static constexpr std::uint32_t wear_threshold__
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_FTL_WEAR_THRESHOLD;
+
+      // Compute the layout from the parent geometry.
+      int
+      configure (void);
+
+      // Rebuild the state from the journal, or format if blank.
+      int
+      mount (void);
+
+      int
+      format (void);
+
+      bool
+      replay (std::size_t area);
+
+      void
+      rebuild (void);
+
+      // Make the current block have a free page.
+      int
+      allocate (void);
+
+      // Point the logical block to the page (or none__).
+      void
+      remap (std::uint32_t blknum, std::uint32_t page);
+
+      // One background collection step.
+      int
+      collect (void);
+
+      // The used block with the fewest valid pages, if any garbage.
+      block_t
+      greedy_victim (void) const;
+
+      // The least worn used block, if the wear levelling is due.
+      block_t
+      cold_victim (void) const;
+
+      // Move the valid pages and erase the block.
+      int
+      reclaim (block_t block, bool cold);
+
+      int
+      erase_data_block (block_t block);
+
+      // Erase whole erase blocks, and check that they were.
+      int
+      erase (blknum_t blknum, std::size_t npages);
+
+      // Queue a map change; full pages are written.
+      int
+      journal_record (std::uint32_t key, std::uint32_t value);
+
+      // Write the pending changes.
+      int
+      journal_flush (void);
+
+      // Write the map to the other area.
+      int
+      checkpoint (void);
+
+      int
+      journal_add (std::uint32_t key, std::uint32_t value,
+                   std::uint16_t flags);
+
+      int
+      journal_write (std::uint16_t flags);
+
+      bool
+      journal_read (std::size_t area, std::size_t index,
+                    journal_header* header);
+
+      // All the pages of the journal area are erased.
+      bool
+      is_blank (std::size_t area);
+
+      bool
+      is_erased (blknum_t blknum);
+
+      blknum_t
+      data_page (std::uint32_t page) const;
+
+      blknum_t
+      area_page (std::size_t area, std::size_t index) const;
+
+      std::size_t
+      area_pages (void) const;
+
+      // ----------------------------------------------------------------------
+
+      block_device& parent_;
+      std::size_t spare_;
+
+      std::size_t pages_per_block_ = 0;
+      // Erase blocks in each journal area.
+      std::size_t journal_blocks_ = 0;
+      // The first data erase block, and their number.
+      std::size_t data_first_ = 0;
+      std::size_t data_blocks_ = 0;
+      std::size_t entries_per_page_ = 0;
+
+      // Logical block to data page.
+      std::uint32_t* map_ = nullptr;
+      // Data page to logical block.
+      std::uint32_t* owners_ = nullptr;
+      // Per data erase block.
+      std::uint32_t* valid_ = nullptr;
+      std::uint32_t* erase_counts_ = nullptr;
+      state* states_ = nullptr;
+
+      std::uint8_t* journal_page_ = nullptr;
+      std::uint8_t* page_buffer_ = nullptr;
+      std::size_t page_size_ = 0;
+
+      std::size_t free_count_ = 0;
+      block_t current_ = none__;
+      std::size_t current_next_ = 0;
+
+      std::size_t journal_area_ = 0;
+      std::size_t journal_next_ = 0;
+      std::size_t journal_count_ = 0;
+      std::uint32_t journal_seq_ = 0;
+
+      bool collecting_ = false;
+      // Moving cold data.
+      bool levelling_ = false;
+      std::size_t erases_ = 0;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ========================================================================
+
+    template <typename T = block_device_ftl_impl>
+    class block_device_ftl_implementable : public block_device_ftl
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      using value_type = T;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      template <typename... Args>
+      block_device_ftl_implementable (const char* name, block_device& parent,
+                                      Args&&... arguments);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_ftl_implementable (const block_device_ftl_implementable&)
+          = delete;
+      block_device_ftl_implementable (block_device_ftl_implementable&&)
+          = delete;
+      block_device_ftl_implementable&
+      operator= (const block_device_ftl_implementable&)
+          = delete;
+      block_device_ftl_implementable&
+      operator= (block_device_ftl_implementable&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_ftl_implementable ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Support functions.
+
+      value_type&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Include the implementation as a member.
+      value_type impl_instance_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
+    template <typename T, typename L>
+    class block_device_ftl_lockable : public block_device_ftl
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      using value_type = T;
+      using lockable_type = L;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      template <typename... Args>
+      block_device_ftl_lockable (const char* name, block_device& parent,
+                                 lockable_type& locker, Args&&... arguments);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_ftl_lockable (const block_device_ftl_lockable&) = delete;
+      block_device_ftl_lockable (block_device_ftl_lockable&&) = delete;
+      block_device_ftl_lockable&
+      operator= (const block_device_ftl_lockable&)
+          = delete;
+      block_device_ftl_lockable&
+      operator= (block_device_ftl_lockable&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_ftl_lockable () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      virtual int
+      close (void) override;
+
+      virtual ssize_t
+      read (void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      write (const void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      readv (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      writev (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual int
+      vfcntl (int cmd, std::va_list arguments) override;
+
+      virtual int
+      vioctl (int request, std::va_list arguments) override;
+
+      virtual off_t
+      lseek (off_t offset, int whence) override;
+
+      virtual ssize_t
+      read_block (void* buf, blknum_t blknum,
+                  std::size_t nblocks = 1) override;
+
+      virtual ssize_t
+      write_block (const void* buf, blknum_t blknum,
+                   std::size_t nblocks = 1) override;
+
+      virtual int
+      submit_block (block_request& request) override;
+
+      virtual int
+      discard_blocks (blknum_t blknum, std::size_t nblocks,
+                      bool secure = false) override;
+
+      virtual int
+      write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual void
+      sync (void) override;
+
+      virtual bool
+      is_lockable (void) const override;
+
+      virtual const void*
+      lock_domain (void) const override;
+
+      virtual int
+      collect (void) override;
+
+      // ----------------------------------------------------------------------
+      // Support functions.
+
+      value_type&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Include the implementation as a member.
+      value_type impl_instance_;
+
+      lockable_type& locker_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    inline std::size_t
+    block_device_ftl::erases (void) const
+    {
+      return impl ().erases_;
+    }
+
+    inline block_device_ftl_impl&
+    block_device_ftl::impl (void) const
+    {
+      return static_cast<block_device_ftl_impl&> (impl_);
+    }
+
+    // ========================================================================
+
+    inline block_device_ftl_impl::blknum_t
+    block_device_ftl_impl::data_page (std::uint32_t page) const
+    {
+      return data_first_ * pages_per_block_ + page;
+    }
+
+    inline block_device_ftl_impl::blknum_t
+    block_device_ftl_impl::area_page (std::size_t area,
+                                      std::size_t index) const
+    {
+      return area * journal_blocks_ * pages_per_block_ + index;
+    }
+
+    inline std::size_t
+    block_device_ftl_impl::area_pages (void) const
+    {
+      return journal_blocks_ * pages_per_block_;
+    }
+
+    // ========================================================================
+
+    template <typename T>
+    template <typename... Args>
+    block_device_ftl_implementable<T>::block_device_ftl_implementable (
+        const char* name, block_device& parent, Args&&... arguments)
+        : block_device_ftl{ impl_instance_, name }, //
+          impl_instance_{ parent, std::forward<Args> (arguments)... }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_implementable::%s(\"%s\")=@%p\n",
+                     __func__, name_, this);
+#endif
+    }
+
+    template <typename T>
+    block_device_ftl_implementable<T>::~block_device_ftl_implementable ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_implementable::%s() @%p %s\n",
+                     __func__, this, name_);
+#endif
+    }
+
+    template <typename T>
+    typename block_device_ftl_implementable<T>::value_type&
+    block_device_ftl_implementable<T>::impl (void) const
+    {
+      return static_cast<value_type&> (impl_);
+    }
+
+    // ========================================================================
+
+    template <typename T, typename L>
+    template <typename... Args>
+    block_device_ftl_lockable<T, L>::block_device_ftl_lockable (
+        const char* name, block_device& parent, lockable_type& locker,
+        Args&&... arguments)
+        : block_device_ftl{ impl_instance_, name }, //
+          impl_instance_{ parent, std::forward<Args> (arguments)... }, //
+          locker_ (locker)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(\"%s\")=@%p\n", __func__,
+                     name_, this);
+#endif
+    }
+
+    template <typename T, typename L>
+    block_device_ftl_lockable<T, L>::~block_device_ftl_lockable ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s() @%p %s\n", __func__,
+                     this, name_);
+#endif
+    }
+
+    // ------------------------------------------------------------------------
+
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s() @%p\n", __func__, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::close ();
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::read (void* buf, std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(0x0%X, %u) @%p\n",
+                     __func__, buf, nbyte, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::read (buf, nbyte);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::write (const void* buf,
+                                            std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(0x0%X, %u) @%p\n",
+                     __func__, buf, nbyte, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::write (buf, nbyte);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::readv (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(0x0%X, %d) @%p\n",
+                     __func__, iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::readv (iov, iovcnt);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::writev (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(0x0%X, %d) @%p\n",
+                     __func__, iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::writev (iov, iovcnt);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::pread (void* buf, std::size_t nbyte,
+                                            off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(0x0%X, %u, %d) @%p\n",
+                     __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::pread (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::pwrite (const void* buf,
+                                             std::size_t nbyte, off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(0x0%X, %u, %d) @%p\n",
+                     __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::pwrite (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::vfcntl (int cmd, std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%d) @%p\n", __func__,
+                     cmd, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::vfcntl (cmd, arguments);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::vioctl (int request,
+                                             std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%d) @%p\n", __func__,
+                     request, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::vioctl (request, arguments);
+    }
+
+    template <typename T, typename L>
+    off_t
+    block_device_ftl_lockable<T, L>::lseek (off_t offset, int whence)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%d, %d) @%p\n", __func__,
+                     offset, whence, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::lseek (offset, whence);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::read_block (void* buf, blknum_t blknum,
+                                                 std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%p, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::read_block (buf, blknum, nblocks);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_ftl_lockable<T, L>::write_block (const void* buf,
+                                                  blknum_t blknum,
+                                                  std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%p, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::write_block (buf, blknum, nblocks);
+    }
+
+    /**
+     * @details
+     * The lock is held only while the request is started, not
+     * until it completes.
+     */
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::submit_block (block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%p) @%p\n", __func__,
+                     &request, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::submit_block (request);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::discard_blocks (blknum_t blknum,
+                                                     std::size_t nblocks,
+                                                     bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%u, %u, %d) @%p\n",
+                     __func__, blknum, nblocks, secure, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::discard_blocks (blknum, nblocks, secure);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::write_zeroes (blknum_t blknum,
+                                                   std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s(%u, %u) @%p\n", __func__,
+                     blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::write_zeroes (blknum, nblocks);
+    }
+
+    template <typename T, typename L>
+    void
+    block_device_ftl_lockable<T, L>::sync (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s() @%p\n", __func__, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::sync ();
+    }
+
+    template <typename T, typename L>
+    bool
+    block_device_ftl_lockable<T, L>::is_lockable (void) const
+    {
+      return true;
+    }
+
+    template <typename T, typename L>
+    const void*
+    block_device_ftl_lockable<T, L>::lock_domain (void) const
+    {
+      return &locker_;
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_ftl_lockable<T, L>::collect (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_lockable::%s() @%p\n", __func__, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_ftl::collect ();
+    }
+
+    template <typename T, typename L>
+    typename block_device_ftl_lockable<T, L>::value_type&
+    block_device_ftl_lockable<T, L>::impl (void) const
+    {
+      return static_cast<value_type&> (impl_);
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_FTL_H_
+
+// ----------------------------------------------------------------------------
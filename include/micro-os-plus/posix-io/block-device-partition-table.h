@@ -0,0 +1,288 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_PARTITION_TABLE_H_
+#define MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_PARTITION_TABLE_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/block-device-partition.h>
+
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+// The maximum number of partitions created for a device.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_PARTITION_TABLE_ENTRIES)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_PARTITION_TABLE_ENTRIES (8)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Partition table scanner class.
+     * @headerfile block-device-partition-table.h
+     * <micro-os-plus/posix-io/block-device-partition-table.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Reads the partition table of a block device, MBR (with the
+     * logical partitions of an extended partition) or GPT, and
+     * creates one partition device for each entry, named after
+     * the parent and the entry number (`sda1`, `sda2`, ...; MBR
+     * logical partitions start at 5). Like all block devices, the
+     * partitions are registered when constructed, and can be
+     * opened by name.
+     *
+     * The GPT header and entries are checked with their CRCs; if
+     * the primary copy is damaged, the backup at the end of the
+     * device is used.
+     *
+     * Partitions which do not start on a physical block boundary
+     * are created, but reported as not aligned, since each write
+     * to them straddles two physical blocks.
+     *
+     * The partitions are not lockable; the requests to them are
+     * serialised by the parent, if it is lockable (or queued).
+     *
+     * @par Example
+     *
+     * @code{.cpp}
+     * posix::block_device_partition_table table{ sda };
+     * table.scan ();
+     * int fd = open ("/dev/sda1", O_RDWR);
+     * @endcode
+     */
+    class block_device_partition_table
+    {
+    public:
+      using blknum_t = block_device::blknum_t;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      block_device_partition_table (block_device& parent);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_partition_table (const block_device_partition_table&)
+          = delete;
+      block_device_partition_table (block_device_partition_table&&) = delete;
+      block_device_partition_table&
+      operator= (const block_device_partition_table&)
+          = delete;
+      block_device_partition_table&
+      operator= (block_device_partition_table&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      // Destroys the partitions.
+      ~block_device_partition_table ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Replace the partitions with those in the table; they must
+      // not be in use. A device without a partition table has no
+      // partitions. Return the number of partitions, or -1 with
+      // errno (EIO if the media cannot be read, EINVAL if the GPT
+      // is damaged).
+      int
+      scan (void);
+
+      // Destroy the partitions.
+      void
+      clear (void);
+
+      std::size_t
+      count (void) const;
+
+      block_device_partition*
+      partition (std::size_t index) const;
+
+      // The entry number, used in the name.
+      unsigned int
+      number (std::size_t index) const;
+
+      bool
+      aligned (std::size_t index) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      struct entry
+      {
+        block_device_partition_implementable<>* device;
+        char* name;
+        unsigned int number;
+        bool aligned;
+      };
+
+      struct candidate
+      {
+        unsigned int number;
+        blknum_t offset;
+        blknum_t nblocks;
+      };
+
+      int
+      scan_mbr (std::uint8_t* buf);
+
+      int
+      scan_extended (std::uint8_t* buf, blknum_t first);
+
+      int
+      scan_gpt (std::uint8_t* buf);
+
+      // Read and check a GPT header and its entries.
+      int
+      read_gpt (std::uint8_t* buf, blknum_t lba, candidate* candidates,
+                std::size_t* count);
+
+      void
+      add (unsigned int number, blknum_t offset, blknum_t nblocks);
+
+      int
+      read (std::uint8_t* buf, blknum_t blknum);
+
+      static constexpr std::size_t entries_max__
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_PARTITION_TABLE_ENTRIES;
+
+      block_device& parent_;
+
+      entry entries_[entries_max__];
+      std::size_t count_ = 0;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    inline std::size_t
+    block_device_partition_table::count (void) const
+    {
+      return count_;
+    }
+
+    inline block_device_partition*
+    block_device_partition_table::partition (std::size_t index) const
+    {
+      return (index < count_) ? entries_[index].device : nullptr;
+    }
+
+    inline unsigned int
+    block_device_partition_table::number (std::size_t index) const
+    {
+      return (index < count_) ? entries_[index].number : 0;
+    }
+
+    inline bool
+    block_device_partition_table::aligned (std::size_t index) const
+    {
+      return (index < count_) ? entries_[index].aligned : false;
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_PARTITION_TABLE_H_
+
+// ----------------------------------------------------------------------------
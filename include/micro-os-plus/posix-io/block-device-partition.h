@@ -68,6 +68,24 @@ namespace micro_os_plus
      * @headerfile block-device-partition.h
      * <micro-os-plus/posix-io/block-device-partitions.h>
      * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Requests are checked once, against the partition range, and
+     * then passed, with the offset applied, directly to the parent
+     * implementation, bypassing the parent wrapper.
+     *
+     * The wrapper of a lockable parent serialises the requests of
+     * all its partitions, so it is bypassed only by a
+     * `block_device_partition_lockable` which shares the parent
+     * locker; such partitions take that single lock, and call the
+     * parent implementation directly. Partitions with their own
+     * locker, or without one, go through the parent wrapper, as do
+     * all partitions of a queued parent, whose requests must pass
+     * through the queue; these must not share the parent locker,
+     * unless it is recursive.
+     *
+     * Opening and closing always go through the parent wrapper,
+     * which keeps the parent open while any partition is open.
      */
     class block_device_partition : public block_device
     {
@@ -137,6 +155,9 @@ namespace micro_os_plus
 
       friend block_device_partition;
 
+      template <typename T, typename L>
+      friend class block_device_partition_lockable;
+
       // ----------------------------------------------------------------------
 
       /**
@@ -192,6 +213,18 @@ namespace micro_os_plus
       do_write_block (const void* buf, blknum_t blknum,
                       std::size_t nblocks) override;
 
+      virtual int
+      do_submit_block (block_request& request) override;
+
+      virtual int
+      do_discard (blknum_t blknum, std::size_t nblocks, bool secure) override;
+
+      virtual int
+      do_write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual blknum_t
+      do_base_block (void) override;
+
       virtual void
       do_sync (void) override;
 
@@ -217,6 +250,12 @@ namespace micro_os_plus
 
       blknum_t partition_offset_blocks_ = 0;
 
+      // The lock of the partition wrapper, if any.
+      const void* lock_domain_ = nullptr;
+
+      // The parent wrapper may be bypassed.
+      bool is_direct_ = false;
+
       /**
        * @endcond
        */
@@ -362,9 +401,33 @@ namespace micro_os_plus
        */
 
     public:
+      virtual ssize_t
+      read (void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      write (const void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      readv (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      writev (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual int
+      vfcntl (int cmd, std::va_list arguments) override;
+
       virtual int
       vioctl (int request, std::va_list arguments) override;
 
+      virtual off_t
+      lseek (off_t offset, int whence) override;
+
       virtual ssize_t
       read_block (void* buf, blknum_t blknum,
                   std::size_t nblocks = 1) override;
@@ -373,6 +436,25 @@ namespace micro_os_plus
       write_block (const void* buf, blknum_t blknum,
                    std::size_t nblocks = 1) override;
 
+      virtual int
+      submit_block (block_request& request) override;
+
+      virtual int
+      discard_blocks (blknum_t blknum, std::size_t nblocks,
+                      bool secure = false) override;
+
+      virtual int
+      write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual void
+      sync (void) override;
+
+      virtual bool
+      is_lockable (void) const override;
+
+      virtual const void*
+      lock_domain (void) const override;
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -479,6 +561,8 @@ namespace micro_os_plus
       trace::printf ("block_device_partition_lockable::%s(\"%s\")=@%p\n",
                      __func__, name_, this);
 #endif
+
+      impl_instance_.lock_domain_ = &locker_;
     }
 
     template <typename T, typename L>
@@ -492,6 +576,113 @@ namespace micro_os_plus
 
     // ------------------------------------------------------------------------
 
+    template <typename T, typename L>
+    ssize_t
+    block_device_partition_lockable<T, L>::read (void* buf, std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(0x0%X, %u) @%p\n",
+                     __func__, buf, nbyte, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::read (buf, nbyte);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_partition_lockable<T, L>::write (const void* buf,
+                                                  std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(0x0%X, %u) @%p\n",
+                     __func__, buf, nbyte, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::write (buf, nbyte);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_partition_lockable<T, L>::readv (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(0x0%X, %d) @%p\n",
+                     __func__, iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::readv (iov, iovcnt);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_partition_lockable<T, L>::writev (const iovec* iov,
+                                                   int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(0x0%X, %d) @%p\n",
+                     __func__, iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::writev (iov, iovcnt);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_partition_lockable<T, L>::pread (void* buf,
+                                                  std::size_t nbyte,
+                                                  off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf (
+          "block_device_partition_lockable::%s(0x0%X, %u, %d) @%p\n",
+          __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::pread (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_partition_lockable<T, L>::pwrite (const void* buf,
+                                                   std::size_t nbyte,
+                                                   off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf (
+          "block_device_partition_lockable::%s(0x0%X, %u, %d) @%p\n",
+          __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::pwrite (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_partition_lockable<T, L>::vfcntl (int cmd,
+                                                   std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(%d) @%p\n", __func__,
+                     cmd, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::vfcntl (cmd, arguments);
+    }
+
     template <typename T, typename L>
     int
     block_device_partition_lockable<T, L>::vioctl (int request,
@@ -507,6 +698,20 @@ namespace micro_os_plus
       return block_device_partition::vioctl (request, arguments);
     }
 
+    template <typename T, typename L>
+    off_t
+    block_device_partition_lockable<T, L>::lseek (off_t offset, int whence)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(%d, %d) @%p\n",
+                     __func__, offset, whence, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::lseek (offset, whence);
+    }
+
     template <typename T, typename L>
     ssize_t
     block_device_partition_lockable<T, L>::read_block (void* buf,
@@ -539,6 +744,85 @@ namespace micro_os_plus
       return block_device_partition::write_block (buf, blknum, nblocks);
     }
 
+    /**
+     * @details
+     * The lock is held only while the request is started, not
+     * until it completes.
+     */
+    template <typename T, typename L>
+    int
+    block_device_partition_lockable<T, L>::submit_block (
+        block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(%p) @%p\n", __func__,
+                     &request, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::submit_block (request);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_partition_lockable<T, L>::discard_blocks (blknum_t blknum,
+                                                           std::size_t nblocks,
+                                                           bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(%u, %u, %d) @%p\n",
+                     __func__, blknum, nblocks, secure, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::discard_blocks (blknum, nblocks, secure);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_partition_lockable<T, L>::write_zeroes (blknum_t blknum,
+                                                         std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s(%u, %u) @%p\n",
+                     __func__, blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::write_zeroes (blknum, nblocks);
+    }
+
+    template <typename T, typename L>
+    void
+    block_device_partition_lockable<T, L>::sync (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_lockable::%s() @%p\n", __func__,
+                     this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device_partition::sync ();
+    }
+
+    template <typename T, typename L>
+    bool
+    block_device_partition_lockable<T, L>::is_lockable (void) const
+    {
+      return true;
+    }
+
+    template <typename T, typename L>
+    const void*
+    block_device_partition_lockable<T, L>::lock_domain (void) const
+    {
+      return &locker_;
+    }
+
     template <typename T, typename L>
     typename block_device_partition_lockable<T, L>::value_type&
     block_device_partition_lockable<T, L>::impl (void) const
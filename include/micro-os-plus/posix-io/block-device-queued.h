@@ -0,0 +1,552 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_QUEUED_H_
+#define MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_QUEUED_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/block-device.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <cstdint>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+// The maximum number of blocks in a merged transfer.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_QUEUE_MERGE_BLOCKS)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_QUEUE_MERGE_BLOCKS (16)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    /**
+     * @brief Block device with an elevator request queue.
+     * @headerfile block-device-queued.h
+     * <micro-os-plus/posix-io/block-device-queued.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * A `block_device_lockable` in which concurrent `read_block()`
+     * and `write_block()` calls are not simply serialised on the
+     * lock, but queued, sorted by block number.
+     *
+     * There is no dispatcher thread: the first caller to find the
+     * queue idle dispatches requests in ascending block order
+     * (C-SCAN), merging each run of contiguous requests in the same
+     * direction into a single driver transfer, through a staging
+     * buffer; each waiter is then completed from its slice. When
+     * its own request is done, the dispatcher passes the role to
+     * the first waiter, so no caller serves the others forever.
+     *
+     * The waiters sleep on an `io_waiter`, so this needs the RTOS
+     * integration of `io_waiter` to actually block.
+     */
+    template <typename T, typename L>
+    class block_device_queued : public block_device_lockable<T, L>
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      using value_type = T;
+      using lockable_type = L;
+      using blknum_t = block_device::blknum_t;
+
+      static constexpr std::size_t merge_blocks
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_QUEUE_MERGE_BLOCKS;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      template <typename... Args>
+      block_device_queued (const char* name, lockable_type& locker,
+                           Args&&... arguments);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_queued (const block_device_queued&) = delete;
+      block_device_queued (block_device_queued&&) = delete;
+      block_device_queued&
+      operator= (const block_device_queued&)
+          = delete;
+      block_device_queued&
+      operator= (block_device_queued&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_queued () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      virtual ssize_t
+      read_block (void* buf, blknum_t blknum,
+                  std::size_t nblocks = 1) override;
+
+      virtual ssize_t
+      write_block (const void* buf, blknum_t blknum,
+                   std::size_t nblocks = 1) override;
+
+      // The requests must go through the queue, even if the lock
+      // is shared.
+      virtual const void*
+      lock_domain (void) const override;
+
+      // The number of driver transfers which served more than one
+      // request.
+      std::size_t
+      merges (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+      // Allocated on the caller stack.
+      struct request
+      {
+        request* next;
+        std::uint8_t* buf;
+        blknum_t blknum;
+        std::size_t nblocks;
+        ssize_t result;
+        int error;
+        bool write;
+        // Set inside the critical section.
+        bool done;
+        bool dispatch;
+        io_waiter waiter;
+      };
+
+#pragma GCC diagnostic pop
+
+      ssize_t
+      submit (request& r);
+
+      // Remove the next run of requests from the queue; return the
+      // last one in the run, and the number of blocks.
+      request*
+      pick (request** first, std::size_t* nblocks);
+
+      void
+      transfer (request* first, request* last, std::size_t nblocks);
+
+      // ----------------------------------------------------------------------
+
+      // Sorted by block number.
+      request* queue_ = nullptr;
+      bool busy_ = false;
+      // The block after the last transfer, for C-SCAN.
+      blknum_t position_ = 0;
+
+      // Allocated at the first merge, and again if the block
+      // size grows.
+      std::uint8_t* staging_ = nullptr;
+      std::size_t staging_size_ = 0;
+
+      std::size_t merges_ = 0;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    template <typename T, typename L>
+    template <typename... Args>
+    block_device_queued<T, L>::block_device_queued (const char* name,
+                                                    lockable_type& locker,
+                                                    Args&&... arguments)
+        : block_device_lockable<T, L>{ name, locker,
+                                       std::forward<Args> (arguments)... }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_queued::%s(\"%s\")=@%p\n", __func__,
+                     this->name_, this);
+#endif
+    }
+
+    template <typename T, typename L>
+    block_device_queued<T, L>::~block_device_queued ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_queued::%s() @%p %s\n", __func__, this,
+                     this->name_);
+#endif
+
+      delete[] staging_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_queued<T, L>::read_block (void* buf, blknum_t blknum,
+                                           std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_queued::%s(%p, %u, %u) @%p\n", __func__,
+                     buf, blknum, nblocks, this);
+#endif
+
+      request r;
+      r.buf = static_cast<std::uint8_t*> (buf);
+      r.blknum = blknum;
+      r.nblocks = nblocks;
+      r.write = false;
+
+      return submit (r);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_queued<T, L>::write_block (const void* buf, blknum_t blknum,
+                                            std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_queued::%s(%p, %u, %u) @%p\n", __func__,
+                     buf, blknum, nblocks, this);
+#endif
+
+      request r;
+      // Only read from, when writing.
+      r.buf = static_cast<std::uint8_t*> (const_cast<void*> (buf));
+      r.blknum = blknum;
+      r.nblocks = nblocks;
+      r.write = true;
+
+      return submit (r);
+    }
+
+    template <typename T, typename L>
+    const void*
+    block_device_queued<T, L>::lock_domain (void) const
+    {
+      return nullptr;
+    }
+
+    template <typename T, typename L>
+    inline std::size_t
+    block_device_queued<T, L>::merges (void) const
+    {
+      return merges_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_queued<T, L>::submit (request& r)
+    {
+      // Validate before queueing, so an invalid request is never
+      // merged with valid ones.
+      const blknum_t blocks = this->blocks ();
+      if ((r.blknum > blocks) || (r.nblocks > blocks - r.blknum))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (r.nblocks == 0)
+        {
+          // Nothing to schedule; handled as by the plain device.
+          using base = block_device_lockable<T, L>;
+          return r.write ? base::write_block (r.buf, r.blknum, 0)
+                         : base::read_block (r.buf, r.blknum, 0);
+        }
+
+      r.done = false;
+      r.dispatch = false;
+      r.waiter.arm ();
+
+      {
+        io_waiter::critical_section cs;
+
+        request** link = &queue_;
+        while ((*link != nullptr) && ((*link)->blknum <= r.blknum))
+          {
+            link = &(*link)->next;
+          }
+        r.next = *link;
+        *link = &r;
+
+        if (!busy_)
+          {
+            busy_ = true;
+            r.dispatch = true;
+          }
+      }
+
+      while (true)
+        {
+          {
+            io_waiter::critical_section cs;
+            if (r.done || r.dispatch)
+              {
+                break;
+              }
+          }
+          r.waiter.wait (nullptr);
+        }
+
+      while (!r.done)
+        {
+          // Dispatch, until the own request is served.
+          request* first;
+          std::size_t nblocks;
+          request* last;
+          {
+            io_waiter::critical_section cs;
+            last = pick (&first, &nblocks);
+          }
+
+          transfer (first, last, nblocks);
+        }
+
+      {
+        io_waiter::critical_section cs;
+
+        if (r.dispatch)
+          {
+            // Pass the role to the first waiter, if any.
+            if (queue_ != nullptr)
+              {
+                queue_->dispatch = true;
+                queue_->waiter.wakeup ();
+              }
+            else
+              {
+                busy_ = false;
+              }
+          }
+      }
+
+      if (r.result < 0)
+        {
+          errno = r.error;
+        }
+      return r.result;
+    }
+
+    template <typename T, typename L>
+    typename block_device_queued<T, L>::request*
+    block_device_queued<T, L>::pick (request** first, std::size_t* nblocks)
+    {
+      // C-SCAN: the first request at or after the current position,
+      // or wrap around to the lowest one.
+      request** link = &queue_;
+      while ((*link != nullptr) && ((*link)->blknum < position_))
+        {
+          link = &(*link)->next;
+        }
+      if (*link == nullptr)
+        {
+          link = &queue_;
+        }
+
+      request* last = *link;
+      std::size_t n = last->nblocks;
+      while ((last->next != nullptr) && (last->next->write == (*link)->write)
+             && (last->next->blknum == last->blknum + last->nblocks)
+             && (n + last->next->nblocks <= merge_blocks))
+        {
+          last = last->next;
+          n += last->nblocks;
+        }
+
+      *first = *link;
+      *link = last->next;
+      last->next = nullptr;
+
+      *nblocks = n;
+      return last;
+    }
+
+    /**
+     * @details
+     * A single request is transferred directly to or from the
+     * caller buffer; a merged run goes through the staging buffer.
+     */
+    template <typename T, typename L>
+    void
+    block_device_queued<T, L>::transfer (request* first, request* last,
+                                         std::size_t nblocks)
+    {
+      const std::size_t size = this->block_logical_size_bytes ();
+      const blknum_t blknum = first->blknum;
+      bool merged = (first != last);
+
+      std::uint8_t* buf = first->buf;
+      if (merged)
+        {
+          if (staging_size_ < merge_blocks * size)
+            {
+              delete[] staging_;
+              staging_size_ = merge_blocks * size;
+              staging_ = new std::uint8_t[staging_size_];
+            }
+          buf = staging_;
+          ++merges_;
+        }
+
+      if (first->write && merged)
+        {
+          for (request* p = first; p != nullptr; p = p->next)
+            {
+              std::memcpy (buf + (p->blknum - blknum) * size, p->buf,
+                           p->nblocks * size);
+            }
+        }
+
+      ssize_t ret;
+      if (first->write)
+        {
+          ret = block_device_lockable<T, L>::write_block (buf, blknum,
+                                                          nblocks);
+        }
+      else
+        {
+          ret = block_device_lockable<T, L>::read_block (buf, blknum,
+                                                         nblocks);
+        }
+      int saved_errno = errno;
+
+      position_ = blknum + nblocks;
+
+      request* p = first;
+      while (p != nullptr)
+        {
+          // May be destroyed as soon as it is done.
+          request* next = p->next;
+
+          ssize_t result = ret;
+          if (ret >= 0)
+            {
+              std::size_t offset = p->blknum - blknum;
+              std::size_t count = static_cast<std::size_t> (ret);
+              count = (count > offset) ? count - offset : 0;
+              if (count > p->nblocks)
+                {
+                  count = p->nblocks;
+                }
+              if (!p->write && merged)
+                {
+                  std::memcpy (p->buf, buf + offset * size, count * size);
+                }
+              result = static_cast<ssize_t> (count);
+            }
+
+          io_waiter::critical_section cs;
+
+          p->result = result;
+          p->error = saved_errno;
+          p->done = true;
+          p->waiter.wakeup ();
+
+          p = next;
+        }
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_QUEUED_H_
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,287 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_STRIPE_H_
+#define MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_STRIPE_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/block-device.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+// The maximum number of devices in a stripe.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_STRIPE_MEMBERS)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_STRIPE_MEMBERS (4)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Striped (RAID-0) block device implementation.
+     * @headerfile block-device-stripe.h
+     * <micro-os-plus/posix-io/block-device-stripe.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Spreads the blocks over several member devices, in chunks of
+     * `chunk_blocks` blocks: chunk 0 on the first member, chunk 1
+     * on the second, and so on, round robin. The capacity is that
+     * of the smallest member, times the number of members.
+     *
+     * Multi-block transfers are split into one request per chunk,
+     * submitted with `block_device::submit_block()`, with up to
+     * one request in flight on each member. There are no worker
+     * threads: the members work concurrently only if their drivers
+     * override `do_submit_block()` to start the transfer and return
+     * before it completes (usually completing it from the
+     * interrupt). With such drivers, sequential transfers larger
+     * than a full stripe (`chunk_blocks` times the number of
+     * members) get the combined bandwidth.
+     *
+     * With the default, synchronous, `do_submit_block()`, each
+     * request completes before the next member is given one, so
+     * the members are accessed one after the other, and the
+     * bandwidth is that of a single member.
+     *
+     * There are no stripe specific functions, so the device is
+     * created as a `block_device_implementable` or, if shared
+     * between threads, as a `block_device_lockable`; the members
+     * are opened and closed together with the stripe, and are
+     * not expected to be used directly meanwhile.
+     *
+     * @par Example
+     *
+     * @code{.cpp}
+     * posix::block_device* cards[] = { &sda, &sdb };
+     * posix::block_device_implementable<posix::block_device_stripe_impl>
+     *     md0{ "md0", cards, 2, 64 };
+     * @endcode
+     */
+    class block_device_stripe_impl : public block_device_impl
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      block_device_stripe_impl (block_device* const* members,
+                                std::size_t count, std::size_t chunk_blocks);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_device_stripe_impl (const block_device_stripe_impl&) = delete;
+      block_device_stripe_impl (block_device_stripe_impl&&) = delete;
+      block_device_stripe_impl&
+      operator= (const block_device_stripe_impl&)
+          = delete;
+      block_device_stripe_impl&
+      operator= (block_device_stripe_impl&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~block_device_stripe_impl () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      virtual int
+      do_vioctl (int request, std::va_list arguments) override;
+
+      virtual int
+      do_vopen (const char* path, int oflag, std::va_list arguments) override;
+
+      virtual ssize_t
+      do_read_block (void* buf, blknum_t blknum, std::size_t nblocks) override;
+
+      virtual ssize_t
+      do_write_block (const void* buf, blknum_t blknum,
+                      std::size_t nblocks) override;
+
+      virtual int
+      do_discard (blknum_t blknum, std::size_t nblocks, bool secure) override;
+
+      virtual int
+      do_write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
+      virtual void
+      do_sync (void) override;
+
+      virtual int
+      do_close (void) override;
+
+      // ----------------------------------------------------------------------
+
+      std::size_t
+      members (void) const;
+
+      std::size_t
+      chunk_blocks (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Split the transfer in chunks and wait for all of them.
+      ssize_t
+      transfer (block_request::opcode op, void* buf, blknum_t blknum,
+                std::size_t nblocks);
+
+      // Wait for the request in flight on the member; return 0 or
+      // the error code.
+      int
+      wait (std::size_t member);
+
+      // The range of the member blocks mapped by the stripe blocks;
+      // false if none.
+      bool
+      member_range (std::size_t member, blknum_t blknum, std::size_t nblocks,
+                    blknum_t* first, blknum_t* last) const;
+
+      int
+      close_members (std::size_t count);
+
+      static void
+      completed (block_request& request);
+
+      static constexpr std::size_t members_max__
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_STRIPE_MEMBERS;
+
+      // The members in flight are kept in an unsigned int mask.
+      static_assert (members_max__ <= 32, "Too many stripe members");
+
+      block_device* members_[members_max__];
+      std::size_t count_;
+      std::size_t chunk_blocks_;
+
+      // One request in flight on each member.
+      block_request requests_[members_max__];
+
+      // Woken up by the member drivers when a request completes.
+      io_waiter waiter_;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    inline std::size_t
+    block_device_stripe_impl::members (void) const
+    {
+      return count_;
+    }
+
+    inline std::size_t
+    block_device_stripe_impl::chunk_blocks (void) const
+    {
+      return chunk_blocks_;
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_BLOCK_DEVICE_STRIPE_H_
+
+// ----------------------------------------------------------------------------
@@ -42,6 +42,34 @@
 
 #include <micro-os-plus/posix-io/device.h>
 
+#include <atomic>
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+// The default read-ahead window, in blocks; 0 disables it.
+// Can be changed at run time with `ioctl(BLKRASET)`.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_READ_AHEAD_BLOCKS)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_READ_AHEAD_BLOCKS (0)
+#endif
+
+// The bounce buffers used for unaligned transfers, shared by all
+// block devices; larger blocks, or more concurrent transfers, use
+// temporary buffers from the heap.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS (2)
+#endif
+
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFER_SIZE)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFER_SIZE (512)
+#endif
+
+// Scattered `readv()`/`writev()` segments shorter than this many
+// blocks are gathered and transferred together.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_GATHER_BLOCKS)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_GATHER_BLOCKS (8)
+#endif
+
 // ----------------------------------------------------------------------------
 
 #pragma GCC diagnostic push
@@ -60,6 +88,7 @@ namespace micro_os_plus
     // ------------------------------------------------------------------------
 
     class block_device_impl;
+    class block_request;
 
     // ========================================================================
 
@@ -119,6 +148,9 @@ namespace micro_os_plus
        */
 
     public:
+      virtual int
+      close (void) override;
+
       virtual int
       vioctl (int request, std::va_list arguments) override;
 
@@ -128,6 +160,26 @@ namespace micro_os_plus
       virtual ssize_t
       write_block (const void* buf, blknum_t blknum, std::size_t nblocks = 1);
 
+      // Start the transfer and return without waiting for it; the
+      // request must stay valid until completed. Return 0 if
+      // accepted, or -1 with errno if invalid, in which case it
+      // is not completed.
+      virtual int
+      submit_block (block_request& request);
+
+      // Tell the media the blocks are no longer used, so flash
+      // devices can erase them in advance; their content becomes
+      // undefined. A secure discard also erases all copies.
+      // File systems should call it, via `device()`, when they
+      // free clusters.
+      // Return 0, or -1 with errno ENOTSUP if not supported.
+      virtual int
+      discard_blocks (blknum_t blknum, std::size_t nblocks,
+                      bool secure = false);
+
+      virtual int
+      write_zeroes (blknum_t blknum, std::size_t nblocks);
+
       // ----------------------------------------------------------------------
 
       /**
@@ -147,6 +199,17 @@ namespace micro_os_plus
       std::size_t
       block_physical_size_bytes (void);
 
+      // True if the requests are serialised by the wrapper, which
+      // thus cannot be bypassed by the stacked devices.
+      virtual bool
+      is_lockable (void) const;
+
+      // The lock taken by the wrapper, if it does nothing else, or
+      // nullptr. Stacked devices serialised by the same lock may
+      // bypass the wrapper.
+      virtual const void*
+      lock_domain (void) const;
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -165,11 +228,120 @@ namespace micro_os_plus
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpadded"
 
+    /**
+     * @brief Asynchronous block transfer request.
+     * @headerfile block-device.h <micro-os-plus/posix-io/block-device.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Filled by the caller and passed to `block_device::submit_block()`.
+     * Drivers able to queue commands keep the request, possibly
+     * with others, and call `complete()` when done, usually from
+     * the interrupt; the result is then available in `done()` and
+     * `result()`, and the callback, if any, is invoked.
+     *
+     * The storage belongs to the caller; the driver may use the
+     * links to keep it in its queues while in flight.
+     */
+    class block_request
+    {
+    public:
+      using blknum_t = block_device::blknum_t;
+
+      enum class opcode : unsigned char
+      {
+        read,
+        write
+      };
+
+      // Called from the completion path, possibly from an interrupt.
+      using callback_t = void (*) (block_request& request);
+
+      // ----------------------------------------------------------------------
+
+      block_request (void) = default;
+
+      block_request (opcode op, void* buf, blknum_t blknum,
+                     std::size_t nblocks, callback_t callback = nullptr,
+                     void* user_data = nullptr);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      block_request (const block_request&) = delete;
+      block_request (block_request&&) = delete;
+      block_request&
+      operator= (const block_request&)
+          = delete;
+      block_request&
+      operator= (block_request&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      ~block_request () = default;
+
+      // ----------------------------------------------------------------------
+
+      // Called by the driver. The result is the number of blocks
+      // transferred; on failure, a negative result and the error
+      // code, since errno is not meaningful in interrupt handlers.
+      void
+      complete (ssize_t result, int error = 0);
+
+      bool
+      done (void) const;
+
+      ssize_t
+      result (void) const;
+
+      int
+      error (void) const;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      opcode op_ = opcode::read;
+      void* buf_ = nullptr;
+      blknum_t blknum_ = 0;
+      std::size_t nblocks_ = 0;
+      callback_t callback_ = nullptr;
+      void* user_data_ = nullptr;
+
+      std::atomic<bool> done_{ false };
+      ssize_t result_ = 0;
+      int error_ = 0;
+
+      // Added to the block number by the partitions passing the
+      // request down; removed before it is completed.
+      blknum_t offset_ = 0;
+
+      // For the driver queues.
+      utils::double_list_links links_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
     class block_device_impl : public device_impl
     {
       // ----------------------------------------------------------------------
 
       friend class block_device;
+      // Partitions of parents which are not lockable, or which
+      // share their lock, dispatch directly to the parent
+      // implementation.
+      friend class block_device_partition_impl;
 
     public:
       using blknum_t = block_device::blknum_t;
@@ -221,6 +393,18 @@ namespace micro_os_plus
       virtual ssize_t
       do_write (const void* buf, std::size_t nbyte) override;
 
+      virtual ssize_t
+      do_readv (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      do_writev (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      do_pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      do_pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
       virtual off_t
       do_lseek (off_t offset, int whence) override;
 
@@ -232,6 +416,30 @@ namespace micro_os_plus
       do_write_block (const void* buf, blknum_t blknum, std::size_t nblocks)
           = 0;
 
+      // Start the transfer of a validated request. The default
+      // executes it synchronously, with do_read_block() or
+      // do_write_block(), and completes it before returning;
+      // drivers supporting command queueing should override it,
+      // to keep more than one command outstanding.
+      // Return 0 if started, or -1 with errno.
+      virtual int
+      do_submit_block (block_request& request);
+
+      // The default does not support discards.
+      virtual int
+      do_discard (blknum_t blknum, std::size_t nblocks, bool secure);
+
+      // The default writes zeroed blocks; drivers with a native
+      // command, or which know discarded blocks read as zeroes,
+      // should override it.
+      virtual int
+      do_write_zeroes (blknum_t blknum, std::size_t nblocks);
+
+      // The first block on the underlying device, used to check the
+      // alignment of discards; non zero only for partitions.
+      virtual blknum_t
+      do_base_block (void);
+
       /**
        * @}
        */
@@ -248,9 +456,116 @@ namespace micro_os_plus
 
       blknum_t num_blocks_ = 0;
 
+      // Read-ahead window, in blocks.
+      std::size_t read_ahead_blocks_
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_READ_AHEAD_BLOCKS;
+      // Allocated at the first sequential read.
+      std::uint8_t* read_ahead_buffer_ = nullptr;
+      // The blocks currently in the buffer.
+      blknum_t read_ahead_first_ = 0;
+      std::size_t read_ahead_count_ = 0;
+      // Where the next read must start to be sequential.
+      blknum_t sequential_next_ = 0;
+
       /**
        * @endcond
        */
+
+      // ----------------------------------------------------------------------
+    protected:
+      // Validate the vector and return its total size; common
+      // code for do_readv() and do_writev().
+      ssize_t
+      validate_iovecs (const iovec* iov, int iovcnt);
+
+      // Check that the bytes are inside the device.
+      bool
+      validate_range (off_t offset, std::size_t nbyte) const;
+
+      // Common code for do_pread(), returns the number of blocks.
+      ssize_t
+      read_ahead (void* buf, blknum_t blknum, std::size_t nblocks);
+
+      // Drop the read-ahead blocks if overwritten.
+      void
+      read_ahead_invalidate (blknum_t blknum, std::size_t nblocks);
+
+      void
+      read_ahead_resize (std::size_t nblocks);
+
+      // Read through the read-ahead buffer, if enabled.
+      ssize_t
+      read_blocks (void* buf, blknum_t blknum, std::size_t nblocks);
+
+      // Transfer part of a block, via a bounce buffer.
+      int
+      read_partial (void* buf, blknum_t blknum, std::size_t skip,
+                    std::size_t nbyte);
+
+      int
+      write_partial (const void* buf, blknum_t blknum, std::size_t skip,
+                     std::size_t nbyte);
+
+      // ----------------------------------------------------------------------
+
+      // A block sized buffer, from a static pool if possible.
+      class bounce_buffer
+      {
+      public:
+        bounce_buffer (std::size_t size);
+
+        /**
+         * @cond ignore
+         */
+
+        // The rule of five.
+        bounce_buffer (const bounce_buffer&) = delete;
+        bounce_buffer (bounce_buffer&&) = delete;
+        bounce_buffer&
+        operator= (const bounce_buffer&)
+            = delete;
+        bounce_buffer&
+        operator= (bounce_buffer&&)
+            = delete;
+
+        /**
+         * @endcond
+         */
+
+        ~bounce_buffer ();
+
+        std::uint8_t*
+        data (void) const;
+
+      protected:
+        /**
+         * @cond ignore
+         */
+
+        std::uint8_t* data_ = nullptr;
+        // -1 if allocated.
+        int index_ = -1;
+
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS > 0
+
+        static constexpr unsigned int pool_buffers__
+            = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS;
+        static constexpr std::size_t pool_buffer_size__
+            = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFER_SIZE;
+
+        static_assert (pool_buffers__ <= 32, "Too many bounce buffers");
+
+        alignas (sizeof (void*)) static std::uint8_t
+            pool__[pool_buffers__][pool_buffer_size__];
+        // One bit per buffer in use.
+        static unsigned int pool_used__;
+
+#endif
+
+        /**
+         * @endcond
+         */
+      };
     };
 
 #pragma GCC diagnostic pop
@@ -393,9 +708,18 @@ namespace micro_os_plus
       virtual ssize_t
       write (const void* buf, std::size_t nbyte) override;
 
+      virtual ssize_t
+      readv (const iovec* iov, int iovcnt) override;
+
       virtual ssize_t
       writev (const iovec* iov, int iovcnt) override;
 
+      virtual ssize_t
+      pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
       virtual int
       vfcntl (int cmd, std::va_list arguments) override;
 
@@ -413,9 +737,25 @@ namespace micro_os_plus
       write_block (const void* buf, blknum_t blknum,
                    std::size_t nblocks = 1) override;
 
+      virtual int
+      submit_block (block_request& request) override;
+
+      virtual int
+      discard_blocks (blknum_t blknum, std::size_t nblocks,
+                      bool secure = false) override;
+
+      virtual int
+      write_zeroes (blknum_t blknum, std::size_t nblocks) override;
+
       virtual void
       sync (void) override;
 
+      virtual bool
+      is_lockable (void) const override;
+
+      virtual const void*
+      lock_domain (void) const override;
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -479,6 +819,46 @@ namespace micro_os_plus
 
     // ========================================================================
 
+    inline std::uint8_t*
+    block_device_impl::bounce_buffer::data (void) const
+    {
+      return data_;
+    }
+
+    // ========================================================================
+
+    inline block_request::block_request (opcode op, void* buf,
+                                         blknum_t blknum, std::size_t nblocks,
+                                         callback_t callback, void* user_data)
+        : op_ (op), //
+          buf_ (buf), //
+          blknum_ (blknum), //
+          nblocks_ (nblocks), //
+          callback_ (callback), //
+          user_data_ (user_data)
+    {
+    }
+
+    inline bool
+    block_request::done (void) const
+    {
+      return done_.load (std::memory_order_acquire);
+    }
+
+    inline ssize_t
+    block_request::result (void) const
+    {
+      return result_;
+    }
+
+    inline int
+    block_request::error (void) const
+    {
+      return error_;
+    }
+
+    // ========================================================================
+
     template <typename T>
     template <typename... Args>
     block_device_implementable<T>::block_device_implementable (
@@ -577,6 +957,20 @@ namespace micro_os_plus
       return block_device::write (buf, nbyte);
     }
 
+    template <typename T, typename L>
+    ssize_t
+    block_device_lockable<T, L>::readv (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_lockable::%s(0x0%X, %d) @%p\n", __func__,
+                     iov, iovcnt, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device::readv (iov, iovcnt);
+    }
+
     template <typename T, typename L>
     ssize_t
     block_device_lockable<T, L>::writev (const iovec* iov, int iovcnt)
@@ -591,6 +985,37 @@ namespace micro_os_plus
       return block_device::writev (iov, iovcnt);
     }
 
+    template <typename T, typename L>
+    ssize_t
+    block_device_lockable<T, L>::pread (void* buf, std::size_t nbyte,
+                                        off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_lockable::%s(0x0%X, %u, %d) @%p\n",
+                     __func__, buf, nbyte, offset, this);
+#endif
+
+      // The lock protects the driver; the offset is not shared.
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device::pread (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    block_device_lockable<T, L>::pwrite (const void* buf, std::size_t nbyte,
+                                         off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_lockable::%s(0x0%X, %u, %d) @%p\n",
+                     __func__, buf, nbyte, offset, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device::pwrite (buf, nbyte, offset);
+    }
+
     template <typename T, typename L>
     int
     block_device_lockable<T, L>::vfcntl (int cmd, std::va_list arguments)
@@ -663,6 +1088,56 @@ namespace micro_os_plus
       return block_device::write_block (buf, blknum, nblocks);
     }
 
+    /**
+     * @details
+     * The lock is held only while the request is started, not
+     * until it completes.
+     */
+    template <typename T, typename L>
+    int
+    block_device_lockable<T, L>::submit_block (block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_lockable::%s(%p) @%p\n", __func__,
+                     &request, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device::submit_block (request);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_lockable<T, L>::discard_blocks (blknum_t blknum,
+                                                 std::size_t nblocks,
+                                                 bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_lockable::%s(%u, %u, %d) @%p\n", __func__,
+                     blknum, nblocks, secure, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device::discard_blocks (blknum, nblocks, secure);
+    }
+
+    template <typename T, typename L>
+    int
+    block_device_lockable<T, L>::write_zeroes (blknum_t blknum,
+                                               std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_lockable::%s(%u, %u) @%p\n", __func__,
+                     blknum, nblocks, this);
+#endif
+
+      std::lock_guard<L> lock{ locker_ };
+
+      return block_device::write_zeroes (blknum, nblocks);
+    }
+
     template <typename T, typename L>
     void
     block_device_lockable<T, L>::sync (void)
@@ -676,6 +1151,20 @@ namespace micro_os_plus
       return block_device::sync ();
     }
 
+    template <typename T, typename L>
+    bool
+    block_device_lockable<T, L>::is_lockable (void) const
+    {
+      return true;
+    }
+
+    template <typename T, typename L>
+    const void*
+    block_device_lockable<T, L>::lock_domain (void) const
+    {
+      return &locker_;
+    }
+
     template <typename T, typename L>
     typename block_device_lockable<T, L>::value_type&
     block_device_lockable<T, L>::impl (void) const
@@ -67,6 +67,11 @@ extern "C"
   int __attribute__ ((weak, alias ("__posix_connect")))
   connect (int socket, const struct sockaddr* address, socklen_t address_len);
 
+  int __attribute__ ((weak, alias ("__posix_dup"))) dup (int fildes);
+
+  int __attribute__ ((weak, alias ("__posix_dup2")))
+  dup2 (int fildes, int fildes2);
+
   int __attribute__ ((weak, alias ("__posix_execve")))
   execve (const char* path, char* const argv[], char* const envp[]);
 
@@ -134,6 +139,12 @@ extern "C"
   DIR* __attribute__ ((weak, alias ("__posix_opendir")))
   opendir (const char* dirname);
 
+  ssize_t __attribute__ ((weak, alias ("__posix_pread")))
+  pread (int fildes, void* buf, size_t nbyte, off_t offset);
+
+  ssize_t __attribute__ ((weak, alias ("__posix_pwrite")))
+  pwrite (int fildes, const void* buf, size_t nbyte, off_t offset);
+
   int __attribute__ ((weak, alias ("__posix_raise"))) raise (int sig);
 
   ssize_t __attribute__ ((weak, alias ("__posix_read")))
@@ -148,6 +159,9 @@ extern "C"
   ssize_t __attribute__ ((weak, alias ("__posix_readlink")))
   readlink (const char* path, char* buf, size_t bufsize);
 
+  ssize_t __attribute__ ((weak, alias ("__posix_readv")))
+  readv (int fildes, const struct iovec* iov, int iovcnt);
+
   ssize_t __attribute__ ((weak, alias ("__posix_recv")))
   recv (int socket, void* buffer, size_t length, int flags);
 
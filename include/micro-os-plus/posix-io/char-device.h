@@ -176,6 +176,12 @@ namespace micro_os_plus
       virtual void
       do_sync (void) override;
 
+      // Drivers with interrupt driven buffers should call
+      // notify_events() when data arrives or space frees up, and
+      // clear_events() when the buffers are empty or full.
+      virtual io::events_t
+      do_poll_events (void) override;
+
       /**
        * @}
        */
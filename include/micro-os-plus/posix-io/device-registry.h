@@ -41,14 +41,24 @@
 // ----------------------------------------------------------------------------
 
 #include <micro-os-plus/posix-io/device.h>
+#include <micro-os-plus/posix-io/static-name-table.h>
+#include <micro-os-plus/posix-io/rcu.h>
 #include <micro-os-plus/diag/trace.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 
 // ----------------------------------------------------------------------------
 
+// Must be a power of 2.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_DEVICE_REGISTRY_BUCKETS)
+#define MICRO_OS_PLUS_INTEGER_POSIX_DEVICE_REGISTRY_BUCKETS (16)
+#endif
+
+// ----------------------------------------------------------------------------
+
 #pragma GCC diagnostic push
 
 #if defined(__clang__)
@@ -59,6 +69,24 @@ namespace micro_os_plus
 {
   namespace posix
   {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Devices known at build time.
+     *
+     * @details
+     * The default (weak) definition returns nullptr. Applications
+     * with a fixed set of devices can redefine it to return the view
+     * of a `constexpr` `static_name_table`, which is looked up before
+     * the devices linked at run time.
+     *
+     * If `MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES` is defined, the
+     * devices no longer link themselves into the registry, and this
+     * table is the only one, so the registry uses no RAM.
+     */
+    const static_name_view<device>*
+    static_device_table (void);
+
     // ========================================================================
 
     /**
@@ -119,6 +147,14 @@ namespace micro_os_plus
       static void
       link (value_type* device);
 
+      // Called by the device destructor; returns after a grace
+      // period, so the device can be safely destroyed.
+      static void
+      unlink (value_type* device);
+
+      // Lock-free, safe while devices are linked or unlinked. The
+      // device may be destroyed as soon as the caller's
+      // `rcu::read_guard` ends, so the guard must also cover its use.
       static value_type*
       identify_device (const char* path);
 
@@ -132,16 +168,27 @@ namespace micro_os_plus
        * @cond ignore
        */
 
+      static std::size_t
+      bucket (const char* name);
+
+      // The devices are hashed by name, so identify_device() checks
+      // only the few devices in one bucket, not all of them.
+      static constexpr std::size_t buckets__
+          = MICRO_OS_PLUS_INTEGER_POSIX_DEVICE_REGISTRY_BUCKETS;
+      static_assert ((buckets__ & (buckets__ - 1)) == 0,
+                     "The number of buckets must be a power of 2");
+
+#if !defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
       // Since devices may be constructed statically, so may ask
-      // to be linked here at any time, this list must be initialised
+      // to be linked here at any time, these lists must be initialised
       // before any static constructor.
-      // With the order of static constructors unknown, this means it
+      // With the order of static constructors unknown, this means they
       // must be allocated in the BSS and will be initialised to 0 by
       // the startup code.
-      using device_list
-          = utils::intrusive_list<device, utils::double_list_links,
-                                  &device::registry_links_, T>;
-      static device_list registry_list__;
+      // Singly linked via device::registry_next_, published with
+      // release stores, so readers need no lock (see `rcu`).
+      static std::atomic<device*> registry_buckets__[buckets__];
+#endif
 
       /**
        * @endcond
@@ -164,25 +211,72 @@ namespace micro_os_plus
     void
     device_registry<T>::link (value_type* device)
     {
+#if defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
+      // All devices are in the static table.
+      (void)device;
+#else
+      auto& head = registry_buckets__[bucket (device->name ())];
+
+      rcu::write_guard wg;
+
 #if defined(DEBUG)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Waggregate-return"
-      for (auto&& d : registry_list__)
+      // Duplicates have the same hash, so are in the same bucket.
+      for (auto* d = head.load (std::memory_order_relaxed); d != nullptr;
+           d = d->registry_next_.load (std::memory_order_relaxed))
         {
           // Validate the device name by checking duplicates.
-          if (std::strcmp (device->name (), d.name ()) == 0)
+          if (std::strcmp (device->name (), d->name ()) == 0)
             {
               trace::puts ("Duplicate device name. Abort.");
               std::abort ();
             }
         }
-#pragma GCC diagnostic pop
 #endif // DEBUG
 
-      registry_list__.link (*device);
+      // Fully link the new device before publishing it.
+      device->registry_next_.store (head.load (std::memory_order_relaxed),
+                                    std::memory_order_relaxed);
+      head.store (device, std::memory_order_release);
 
       trace::printf ("Device '%s%s' linked.\n", value_type::device_prefix (),
                      device->name ());
+#endif // MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES
+    }
+
+    /**
+     * @details
+     * The device is removed from its bucket, but its own link is
+     * left intact, so readers already positioned on it can continue
+     * the walk; once the grace period ends, none can reach it.
+     */
+    template <typename T>
+    void
+    device_registry<T>::unlink (value_type* device)
+    {
+#if defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
+      (void)device;
+#else
+      if (device->name () == nullptr)
+        {
+          return;
+        }
+
+      rcu::write_guard wg;
+
+      auto* link = &registry_buckets__[bucket (device->name ())];
+      for (auto* d = link->load (std::memory_order_relaxed); d != nullptr;
+           d = link->load (std::memory_order_relaxed))
+        {
+          if (d == device)
+            {
+              link->store (d->registry_next_.load (std::memory_order_relaxed),
+                           std::memory_order_release);
+              rcu::synchronize ();
+              return;
+            }
+          link = &d->registry_next_;
+        }
+#endif // MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES
     }
 
     /**
@@ -195,30 +289,71 @@ namespace micro_os_plus
       assert (path != nullptr);
 
       auto prefix = value_type::device_prefix ();
-      if (std::strncmp (prefix, path, std::strlen (prefix)) != 0)
+      auto prefix_length = std::strlen (prefix);
+      if (std::strncmp (prefix, path, prefix_length) != 0)
         {
-          // The device prefix does not match, not a device.
+          // The device prefix does not match, not a device; regular
+          // file paths leave here, without checking any device.
           return nullptr;
         }
 
       // The prefix was identified; try to match the rest of the path.
-      auto name = path + std::strlen (prefix);
+      auto name = path + prefix_length;
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Waggregate-return"
-      for (auto&& p : registry_list__)
+      auto* const table = static_device_table ();
+      if (table != nullptr)
         {
-          if (p.match_name (name))
+          auto* const d = table->find (name);
+          if (d != nullptr)
             {
-              return static_cast<value_type*> (&p);
+              return static_cast<value_type*> (d);
             }
         }
-#pragma GCC diagnostic pop
+
+#if !defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
+      rcu::read_guard rg;
+
+      // The bucket of the name first. Devices which override
+      // match_name() may accept names other than their own, for
+      // example with a prefix or a pattern, so may be in any bucket;
+      // all the others are also asked, but only if no device matched
+      // by name.
+      const std::size_t first = bucket (name);
+      for (std::size_t n = 0; n < buckets__; ++n)
+        {
+          auto& head = registry_buckets__[(first + n) & (buckets__ - 1)];
+          for (auto* d = head.load (std::memory_order_acquire); d != nullptr;
+               d = d->registry_next_.load (std::memory_order_acquire))
+            {
+              if (d->match_name (name))
+                {
+                  return static_cast<value_type*> (d);
+                }
+            }
+        }
+#endif // !MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES
 
       // Not a known device.
       return nullptr;
     }
 
+    /**
+     * @details
+     * FNV-1a, short and good enough for device names.
+     */
+    template <typename T>
+    std::size_t
+    device_registry<T>::bucket (const char* name)
+    {
+      std::uint32_t h = 2166136261u;
+      for (; *name != '\0'; ++name)
+        {
+          h ^= static_cast<unsigned char> (*name);
+          h *= 16777619u;
+        }
+      return static_cast<std::size_t> (h) & (buckets__ - 1);
+    }
+
     /**
      * @cond ignore
      */
@@ -229,10 +364,11 @@ namespace micro_os_plus
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 #endif
 
+#if !defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
     // Initialised to 0 by BSS.
     template <typename T>
-    typename device_registry<T>::device_list
-        device_registry<T>::registry_list__;
+    std::atomic<device*> device_registry<T>::registry_buckets__[buckets__];
+#endif
 
 #pragma GCC diagnostic pop
 
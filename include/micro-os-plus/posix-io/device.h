@@ -155,6 +155,10 @@ namespace micro_os_plus
 
       // ----------------------------------------------------------------------
 
+      // The registry hashes the path by the device name, and asks
+      // first the devices whose name() hashes the same; overrides
+      // which accept other names are still asked, by a full scan,
+      // when no device matched by name.
       virtual bool
       match_name (const char* name) const;
 
@@ -192,9 +196,9 @@ namespace micro_os_plus
        * @cond ignore
        */
 
-      // Intrusive node used to link this device to the registry list.
+      // Link to the next device in the registry bucket.
       // Must be public.
-      utils::double_list_links registry_links_;
+      std::atomic<device*> registry_next_{ nullptr };
 
       /**
        * @endcond
@@ -0,0 +1,496 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_EVENT_POLLER_H_
+#define MICRO_OS_PLUS_POSIX_IO_EVENT_POLLER_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/io.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <micro-os-plus/utils/lists.h>
+
+#include <cstddef>
+#include <ctime>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#pragma GCC diagnostic ignored "-Wsuggest-final-types"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    class event_poller_impl;
+
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Event poller class, similar to Linux epoll.
+     * @headerfile event-poller.h <micro-os-plus/posix-io/event-poller.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Descriptors are registered once, with `add()`; afterwards the
+     * drivers push them into the poller ready list when they call
+     * `io_impl::notify_events()`, so `wait()` costs O(number ready),
+     * not O(number registered) like select().
+     *
+     * The poller is itself an `io`, with a file descriptor; it is
+     * readable when there are ready events, thus it can be
+     * registered in another poller or passed to select().
+     *
+     * Only one thread at a time should wait on a poller.
+     */
+    class event_poller : public io
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      /**
+       * @name Types & Constants
+       * @{
+       */
+
+      // Flags, to be or-ed with the io::event bits in add()/modify().
+
+      // Report only changes, not the state.
+      static constexpr io::events_t edge_triggered = 1u << 30;
+
+      // Disable the registration after the first report, until
+      // re-armed with modify().
+      static constexpr io::events_t one_shot = 1u << 29;
+
+      struct event
+      {
+        io::events_t events;
+        void* data;
+      };
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      event_poller (event_poller_impl& impl);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      event_poller (const event_poller&) = delete;
+      event_poller (event_poller&&) = delete;
+      event_poller&
+      operator= (const event_poller&)
+          = delete;
+      event_poller&
+      operator= (event_poller&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~event_poller ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Allocate a file descriptor. Return it, or -1 on error.
+      int
+      open (void);
+
+      int
+      add (int fildes, io::events_t events, void* data = nullptr);
+
+      int
+      modify (int fildes, io::events_t events, void* data = nullptr);
+
+      int
+      remove (int fildes);
+
+      // Return the number of events stored in the array, 0 if the
+      // timeout expired, or -1 on error.
+      // A null timeout waits forever.
+      int
+      wait (event* events, int max_events, timespec* timeout);
+
+      // Support functions.
+
+      event_poller_impl&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+
+    };
+
+    // ========================================================================
+
+    class event_poller_impl : public io_impl
+    {
+      // ----------------------------------------------------------------------
+
+      friend class event_poller;
+
+    public:
+      /**
+       * @cond ignore
+       */
+
+      // One registration, subscribed to the io.
+      class item : public io_listener
+      {
+      public:
+        item (void) = default;
+
+        virtual ~item () override = default;
+
+        virtual void
+        notify (io_impl& impl, io::events_t events) override;
+
+        virtual void
+        detach (io_impl& impl) override;
+
+        event_poller_impl* poller_ = nullptr;
+        class io* io_ = nullptr;
+        io::events_t events_ = 0;
+        void* data_ = nullptr;
+
+        // Set while collect_events() polls the io; a release in the
+        // meantime leaves the recycling to collect_events().
+        bool busy_ = false;
+
+        // Links either in the ready list or in the free list.
+        utils::double_list_links ready_links_;
+      };
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      // The maximum number of registrations is fixed, the storage is
+      // allocated once, in the constructor.
+      event_poller_impl (std::size_t max_items);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      event_poller_impl (const event_poller_impl&) = delete;
+      event_poller_impl (event_poller_impl&&) = delete;
+      event_poller_impl&
+      operator= (const event_poller_impl&)
+          = delete;
+      event_poller_impl&
+      operator= (event_poller_impl&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~event_poller_impl () override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Implementations
+
+      virtual bool
+      do_is_opened (void) override;
+
+      virtual ssize_t
+      do_read (void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      do_write (const void* buf, std::size_t nbyte) override;
+
+      virtual off_t
+      do_lseek (off_t offset, int whence) override;
+
+      virtual int
+      do_close (void) override;
+
+      virtual io::events_t
+      do_poll_events (void) override;
+
+      virtual int
+      do_add (class io* io, io::events_t events, void* data);
+
+      virtual int
+      do_modify (class io* io, io::events_t events, void* data);
+
+      virtual int
+      do_remove (class io* io);
+
+      virtual int
+      do_wait (event_poller::event* events, int max_events,
+               timespec* timeout);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      item*
+      find_item (class io* io);
+
+      // Queue the item if the io is already ready.
+      void
+      check_ready (item* it);
+
+      void
+      release_item (item* it);
+
+      int
+      collect_events (event_poller::event* events, int max_events);
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      using items_list
+          = utils::intrusive_list<item, utils::double_list_links,
+                                  &item::ready_links_>;
+
+      items_list ready_list_;
+      items_list free_list_;
+
+      item* items_array_ = nullptr;
+      std::size_t max_items_ = 0;
+
+      io_waiter waiter_;
+
+      bool is_opened_ = false;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
+    template <typename T = event_poller_impl>
+    class event_poller_implementable : public event_poller
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      using value_type = T;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      template <typename... Args>
+      event_poller_implementable (Args&&... arguments);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      event_poller_implementable (const event_poller_implementable&)
+          = delete;
+      event_poller_implementable (event_poller_implementable&&) = delete;
+      event_poller_implementable&
+      operator= (const event_poller_implementable&)
+          = delete;
+      event_poller_implementable&
+      operator= (event_poller_implementable&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~event_poller_implementable ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Support functions.
+
+      value_type&
+      impl (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      value_type impl_instance_;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    inline event_poller_impl&
+    event_poller::impl (void) const
+    {
+      return static_cast<event_poller_impl&> (impl_);
+    }
+
+    // ========================================================================
+
+    template <typename T>
+    template <typename... Args>
+    event_poller_implementable<T>::event_poller_implementable (
+        Args&&... arguments)
+        : event_poller{ impl_instance_ }, //
+          impl_instance_{ std::forward<Args> (arguments)... }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller_implementable::%s()=@%p\n", __func__,
+                     this);
+#endif
+    }
+
+    template <typename T>
+    event_poller_implementable<T>::~event_poller_implementable ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller_implementable::%s() @%p\n", __func__,
+                     this);
+#endif
+    }
+
+    template <typename T>
+    typename event_poller_implementable<T>::value_type&
+    event_poller_implementable<T>::impl (void) const
+    {
+      return static_cast<value_type&> (impl_);
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_EVENT_POLLER_H_
+
+// ----------------------------------------------------------------------------
@@ -41,9 +41,12 @@
 // ----------------------------------------------------------------------------
 
 #include <micro-os-plus/posix-io/types.h>
+#include <micro-os-plus/posix-io/io.h>
 
 #include <cstddef>
 #include <cassert>
+#include <climits>
+#include <atomic>
 
 // ----------------------------------------------------------------------------
 
@@ -79,13 +82,70 @@ namespace micro_os_plus
     {
       // ----------------------------------------------------------------------
 
+    public:
+      /**
+       * @brief Scoped reference to the io behind a descriptor.
+       *
+       * @details
+       * While pinned, the io object is not reclaimed, even if
+       * another thread closes the descriptor; the call then fails
+       * with EBADF instead of touching freed memory.
+       */
+      class pinned_io
+      {
+      public:
+        pinned_io (int fildes);
+
+        /**
+         * @cond ignore
+         */
+
+        // The rule of five.
+        pinned_io (const pinned_io&) = delete;
+        pinned_io (pinned_io&&) = delete;
+        pinned_io&
+        operator= (const pinned_io&)
+            = delete;
+        pinned_io&
+        operator= (pinned_io&&)
+            = delete;
+
+        /**
+         * @endcond
+         */
+
+        ~pinned_io ();
+
+        class io*
+        get (void) const;
+
+        // Null if not a socket.
+        class socket*
+        socket (void) const;
+
+      protected:
+        /**
+         * @cond ignore
+         */
+
+        class io* io_;
+
+        /**
+         * @endcond
+         */
+      };
+
+      // ----------------------------------------------------------------------
+
       /**
        * @name Constructors & Destructor
        * @{
        */
 
     public:
-      file_descriptors_manager (std::size_t size);
+      // The table grows on demand up to `size` descriptors (plus the
+      // standard ones); `initial` slots are mapped upfront.
+      file_descriptors_manager (std::size_t size, std::size_t initial = 0);
 
       /**
        * @cond ignore
@@ -118,14 +178,34 @@ namespace micro_os_plus
        */
 
     public:
+      // The maximum number of descriptors, including the standard ones.
       static size_t
       size (void);
 
+      // The number of descriptors currently backed by memory.
+      static size_t
+      capacity (void);
+
+      // Give back the memory of the trailing unused pages; returns
+      // the number of slots released.
+      static size_t
+      shrink (void);
+
       static bool
       valid (int fildes);
       static class io*
       io (int fildes);
 
+      // Return the io with its pin count incremented, or nullptr;
+      // for references which outlive a scope, like asynchronous
+      // requests. Each successful pin() must be paired with unpin().
+      static class io*
+      pin (int fildes);
+
+      // Safe to be called from interrupt handlers.
+      static void
+      unpin (class io* io);
+
       static class socket*
       socket (int fildes);
 
@@ -135,12 +215,40 @@ namespace micro_os_plus
       static int
       assign (file_descriptor_t fildes, class io* io);
 
+      // Release a single descriptor; returns the number of
+      // descriptors still referring to the same io, or -1.
       static int
       deallocate (file_descriptor_t fildes);
 
+      // Release all descriptors referring to the io.
+      static int
+      deallocate (class io* io);
+
+      // A new descriptor, the lowest available, referring to the
+      // same open file description as `fildes`.
+      static int
+      dup (file_descriptor_t fildes);
+
+      // Make `fildes2` refer to the same open file description as
+      // `fildes`, closing its previous one if it was the last
+      // reference.
+      static int
+      dup2 (file_descriptor_t fildes, file_descriptor_t fildes2);
+
+      // O(1), the count is maintained by allocate()/deallocate().
       static size_t
       used (void);
 
+      // True if a closed io object can be destroyed or reused: no
+      // thread is still pinning it, or is about to.
+      static bool
+      is_reclaimable (class io* io);
+
+      // The number of descriptors of the given type (a single
+      // io::type bit); a tty is also counted as a char device.
+      static size_t
+      used (io::type_t type);
+
       /**
        * @}
        */
@@ -156,7 +264,92 @@ namespace micro_os_plus
 
       static std::size_t size__;
 
-      static class io** descriptors_array__;
+      using bitmap_word_t = unsigned long;
+      static constexpr std::size_t bits_per_word__
+          = sizeof (bitmap_word_t) * CHAR_BIT;
+
+      // A page groups one bitmap word with the slots it describes.
+      // Pages are never moved once published, so a concurrent reader
+      // always sees either nullptr or a complete pointer.
+      struct page
+      {
+        // One bit per descriptor, set when in use. The reserved
+        // descriptors and the bits past the end are permanently set,
+        // so allocate() only looks for the first zero bit; a retired
+        // page is fully set.
+        std::atomic<bitmap_word_t> used;
+
+        std::atomic<class io*> slots[bits_per_word__];
+
+        page* retired_next;
+
+        // The index in the first level, to find its lookups counter
+        // once retired.
+        std::size_t number;
+      };
+
+      static constexpr std::size_t slots_per_page__ = bits_per_word__;
+
+      // The first level, allocated upfront; a null entry is a page
+      // not mapped yet, or already given back.
+      static std::atomic<page*>* pages__;
+      static std::size_t pages_count__;
+
+      static std::atomic<std::size_t> mapped_pages__;
+
+      // Pages unlinked by shrink(), but possibly still seen by a
+      // lookup in progress; freed once no lookup is in progress.
+      static page* retired__;
+      static std::atomic_flag shrinking__;
+
+      static std::atomic<std::size_t> used__;
+
+      // Indexed by the io::type bit number.
+      static constexpr std::size_t types__ = sizeof (io::type_t) * CHAR_BIT;
+      static std::atomic<std::size_t> type_used__[types__];
+
+      // One per page, allocated with the first level: threads
+      // between loading the page or one of its slots and using it.
+      // Lookups on descriptors in different pages do not share it.
+      static std::atomic<std::size_t>* lookups__;
+
+      // Load the io in the given slot; the lookups counter of its
+      // page must be held.
+      static class io*
+      load (std::size_t i);
+
+      static bool
+      is_lookup_in_progress (void);
+
+      static void
+      count (class io* io, int delta);
+
+      static bitmap_word_t
+      initial_bits (std::size_t p);
+
+      static int
+      claim (class io* io);
+
+      static class io*
+      place (std::size_t i, class io* io);
+
+      static int
+      release (std::size_t i, class io* io);
+
+      static int
+      drop (class io* io, std::size_t i);
+
+      static bool
+      retain (class io* io);
+
+      static int
+      find (class io* io);
+
+      static page*
+      map_page (std::size_t p);
+
+      static void
+      free_retired (void);
 
       /**
        * @endcond
@@ -181,6 +374,20 @@ namespace micro_os_plus
       return size__;
     }
 
+    inline size_t
+    file_descriptors_manager::capacity (void)
+    {
+      std::size_t n
+          = mapped_pages__.load (std::memory_order_relaxed) * slots_per_page__;
+      return (n < size__) ? n : size__;
+    }
+
+    inline class io*
+    file_descriptors_manager::pinned_io::get (void) const
+    {
+      return io_;
+    }
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus
@@ -42,11 +42,14 @@
 
 #include <micro-os-plus/posix-io/file.h>
 #include <micro-os-plus/posix-io/directory.h>
+#include <micro-os-plus/posix-io/file-descriptors-manager.h>
+#include <micro-os-plus/posix-io/static-name-table.h>
 
 #include <micro-os-plus/utils/lists.h>
 
 #include <micro-os-plus/diag/trace.h>
 
+#include <atomic>
 #include <mutex>
 #include <cstdarg>
 #include <sys/stat.h>
@@ -83,6 +86,25 @@ namespace micro_os_plus
     class block_device;
 
     class file_system_impl;
+    class file_system;
+
+    /**
+     * @brief Mount points known at build time.
+     *
+     * @details
+     * The default (weak) definition returns nullptr. Applications
+     * with a fixed set of mount points can redefine it to return the
+     * view of a `constexpr` `static_name_table`, with the mount
+     * paths as names, in the canonical form (like `/data/`). The
+     * file systems must still be mounted at run time; until then
+     * their entries are ignored.
+     *
+     * If `MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES` is defined,
+     * mounting does not build the mount trie, so this table is the
+     * only one, in addition to the root file system.
+     */
+    const static_name_view<file_system>*
+    static_mount_table (void);
 
     /**
      * @ingroup micro-os-plus-posix-io-function
@@ -259,6 +281,22 @@ namespace micro_os_plus
       virtual int
       umount (int unsigned flags = 0);
 
+      /**
+       * @brief Identify the file system of a path.
+       *
+       * @param path1 Pointer to the path; adjusted to the path
+       *   inside the file system, starting with `/`.
+       * @param path2 Optional second path (for rename()); adjusted
+       *   the same way, or set to nullptr if it belongs to a
+       *   different file system.
+       * @return The file system with the longest mount path matching
+       *   the path, the root file system, or nullptr.
+       *
+       * @details
+       * The file system may be unmounted as soon as the caller's
+       * `rcu::read_guard` ends, so the guard must also cover
+       * the calls to the returned file system.
+       */
       static file_system*
       identify_mounted (const char** path1, const char** path2 = nullptr);
 
@@ -392,6 +430,26 @@ namespace micro_os_plus
 
       const char* mounted_path_ = nullptr;
 
+      // A trie of mount points, one node per path component; a node
+      // may have a file system mounted, or only be on the path to
+      // deeper mount points.
+      // Readers walk it under an `rcu::read_guard`, so the links
+      // followed by them are atomic; name, length and parent do not
+      // change while the node is published.
+      struct mount_node
+      {
+        char* name;
+        std::size_t length;
+
+        std::atomic<file_system*> fs;
+
+        mount_node* parent;
+        std::atomic<mount_node*> children;
+        std::atomic<mount_node*> next;
+      };
+
+      mount_node* mount_node_ = nullptr;
+
       /**
        * @endcond
        */
@@ -418,12 +476,25 @@ namespace micro_os_plus
        */
 
       // Statics.
+      // Changed and walked only with the `rcu::write_guard` held.
       using mounted_list
           = utils::intrusive_list<file_system, utils::double_list_links,
                                   &file_system::mount_manager_links_>;
       static mounted_list mounted_list__;
 
-      static file_system* mounted_root__;
+      static std::atomic<file_system*> mounted_root__;
+
+      // The first level of the mount trie.
+      static std::atomic<mount_node*> mount_nodes__;
+
+      static mount_node*
+      find_mount_node (const char* path, bool create);
+
+      static void
+      prune_mount_node (mount_node* node);
+
+      static file_system*
+      match_mounted (const char** path);
 
       /**
        * @endcond
@@ -845,7 +916,10 @@ namespace micro_os_plus
 
       file_type* fil;
 
-      if (deferred_files_list_.empty ())
+      // Reuse a closed file only if no other thread still uses it.
+      if (deferred_files_list_.empty ()
+          || !file_descriptors_manager::is_reclaimable (
+              deferred_files_list_.head ()))
         {
           fil = new file_type (*this);
         }
@@ -872,7 +946,10 @@ namespace micro_os_plus
 
       file_type* fil;
 
-      if (deferred_files_list_.empty ())
+      // Reuse a closed file only if no other thread still uses it.
+      if (deferred_files_list_.empty ()
+          || !file_descriptors_manager::is_reclaimable (
+              deferred_files_list_.head ()))
         {
           fil = new file_type (*this, locker);
         }
@@ -897,15 +974,28 @@ namespace micro_os_plus
     {
       using file_type = T;
 
-      // Deallocate all remaining elements in the list.
+      // Deallocate all remaining elements in the list, except those
+      // still pinned by other threads, which are kept for later.
+      deferred_files_list_t pinned_list;
       while (!deferred_files_list_.empty ())
         {
           file_type* f
               = static_cast<file_type*> (deferred_files_list_.unlink_head ());
 
+          if (!file_descriptors_manager::is_reclaimable (f))
+            {
+              pinned_list.link (*f);
+              continue;
+            }
+
           // Call the destructor and the deallocator.
           delete f;
         }
+
+      while (!pinned_list.empty ())
+        {
+          deferred_files_list_.link (*pinned_list.unlink_head ());
+        }
     }
 
     template <typename T>
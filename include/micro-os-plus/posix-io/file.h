@@ -239,6 +239,18 @@ namespace micro_os_plus
       do_fsync (void)
           = 0;
 
+      virtual ssize_t
+      do_readv (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      do_writev (const iovec* iov, int iovcnt) override;
+
+      virtual ssize_t
+      do_pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      do_pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -396,9 +408,18 @@ namespace micro_os_plus
       virtual ssize_t
       write (const void* buf, std::size_t nbyte) override;
 
+      virtual ssize_t
+      readv (const iovec* iov, int iovcnt) override;
+
       virtual ssize_t
       writev (const iovec* iov, int iovcnt) override;
 
+      virtual ssize_t
+      pread (void* buf, std::size_t nbyte, off_t offset) override;
+
+      virtual ssize_t
+      pwrite (const void* buf, std::size_t nbyte, off_t offset) override;
+
       virtual int
       vfcntl (int cmd, std::va_list arguments) override;
 
@@ -552,6 +573,15 @@ namespace micro_os_plus
       return file::write (buf, nbyte);
     }
 
+    template <typename T, typename L>
+    ssize_t
+    file_lockable<T, L>::readv (const iovec* iov, int iovcnt)
+    {
+      std::lock_guard<L> lock{ locker_ };
+
+      return file::readv (iov, iovcnt);
+    }
+
     template <typename T, typename L>
     ssize_t
     file_lockable<T, L>::writev (const iovec* iov, int iovcnt)
@@ -561,6 +591,25 @@ namespace micro_os_plus
       return file::writev (iov, iovcnt);
     }
 
+    template <typename T, typename L>
+    ssize_t
+    file_lockable<T, L>::pread (void* buf, std::size_t nbyte, off_t offset)
+    {
+      std::lock_guard<L> lock{ locker_ };
+
+      return file::pread (buf, nbyte, offset);
+    }
+
+    template <typename T, typename L>
+    ssize_t
+    file_lockable<T, L>::pwrite (const void* buf, std::size_t nbyte,
+                                 off_t offset)
+    {
+      std::lock_guard<L> lock{ locker_ };
+
+      return file::pwrite (buf, nbyte, offset);
+    }
+
     template <typename T, typename L>
     int
     file_lockable<T, L>::vfcntl (int cmd, std::va_list arguments)
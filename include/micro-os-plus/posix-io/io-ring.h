@@ -0,0 +1,363 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_IO_RING_H_
+#define MICRO_OS_PLUS_POSIX_IO_IO_RING_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/io.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <micro-os-plus/utils/lists.h>
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#pragma GCC diagnostic ignored "-Wsuggest-final-types"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    class io_ring;
+
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief In flight I/O request.
+     * @headerfile io-ring.h <micro-os-plus/posix-io/io-ring.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Requests are passed to `io_impl::do_submit()`; drivers able
+     * to start the transfer in background keep the reference and,
+     * when done, usually from the interrupt, call `complete()`.
+     */
+    class io_request
+    {
+    public:
+      enum class opcode : unsigned char
+      {
+        nop = 0,
+        read,
+        write,
+        readv, // buf_ is a `const iovec*`, nbyte_ the iovcnt.
+        writev,
+        fsync
+      };
+
+      // ----------------------------------------------------------------------
+
+      io_request (void) = default;
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      io_request (const io_request&) = delete;
+      io_request (io_request&&) = delete;
+      io_request&
+      operator= (const io_request&)
+          = delete;
+      io_request&
+      operator= (io_request&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      ~io_request () = default;
+
+      // ----------------------------------------------------------------------
+
+      // Post the result in the completion ring. On failure, pass
+      // a negative result and the error code, since errno is not
+      // meaningful in interrupt handlers.
+      void
+      complete (ssize_t result, int error = 0);
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      opcode op_ = opcode::nop;
+      class io* io_ = nullptr;
+      void* buf_ = nullptr;
+      std::size_t nbyte_ = 0;
+      // A negative offset means the current file position.
+      off_t offset_ = -1;
+      void* user_data_ = nullptr;
+
+      io_ring* ring_ = nullptr;
+      utils::double_list_links free_links_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
+    /**
+     * @brief Submission/completion rings for batched I/O.
+     * @headerfile io-ring.h <micro-os-plus/posix-io/io-ring.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Similar to Linux io_uring: the application fills entries
+     * in the submission ring and publishes them with a single
+     * `submit()`; a worker (a thread running `run()`, or the
+     * application itself via `process()`) consumes them and
+     * passes them to the drivers; results are posted in the
+     * completion ring, either immediately, for synchronous
+     * drivers, or later, from the driver completion path.
+     *
+     * The submission side is single producer (one application
+     * thread) and single consumer (the worker).
+     */
+    class io_ring
+    {
+      // ----------------------------------------------------------------------
+
+      friend class io_request;
+
+    public:
+      /**
+       * @name Types & Constants
+       * @{
+       */
+
+      using opcode = io_request::opcode;
+
+      struct submission
+      {
+        opcode op;
+        int fildes;
+        void* buf;
+        std::size_t nbyte;
+        // A negative offset means the current file position.
+        off_t offset;
+        void* user_data;
+      };
+
+      struct completion
+      {
+        ssize_t result;
+        int error;
+        void* user_data;
+      };
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      // The number of entries must be a power of 2; this is also the
+      // maximum number of requests in flight. The completion ring is
+      // twice as large. Storage is allocated once, here.
+      io_ring (std::size_t entries);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      io_ring (const io_ring&) = delete;
+      io_ring (io_ring&&) = delete;
+      io_ring&
+      operator= (const io_ring&)
+          = delete;
+      io_ring&
+      operator= (io_ring&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      ~io_ring ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Application side.
+
+      // Return the next free submission entry, or nullptr if the
+      // ring is full. Entries are not visible until submit().
+      submission*
+      get_submission (void);
+
+      // Publish all entries obtained so far. Return their number.
+      int
+      submit (void);
+
+      // Wait until at least min_complete completions are available.
+      // Return the number of available completions, possibly less
+      // than requested if the timeout expired, or -1 on error.
+      // If no worker runs, the submissions are processed inline.
+      int
+      wait_completions (std::size_t min_complete, timespec* timeout);
+
+      // Return the oldest completion, or nullptr if none.
+      completion*
+      peek_completion (void);
+
+      // Release the completion returned by peek_completion().
+      void
+      advance_completion (void);
+
+      // Worker side.
+
+      // Consume the published submissions and start them. Return
+      // the number consumed. Stop early if too many requests are
+      // in flight.
+      int
+      process (void);
+
+      // Worker thread body; returns after stop().
+      void
+      run (void);
+
+      void
+      stop (void);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      void
+      start (io_request* request);
+
+      void
+      execute (io_request* request);
+
+      void
+      post_completion (io_request* request, ssize_t result, int error);
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      std::size_t sq_mask_;
+      std::size_t cq_mask_;
+
+      submission* sq_array_ = nullptr;
+      completion* cq_array_ = nullptr;
+      io_request* requests_array_ = nullptr;
+
+      // Free running counters; the index is masked. Shared by the
+      // application and the worker thread.
+      std::atomic<std::size_t> sq_head_{ 0 };
+      std::atomic<std::size_t> sq_tail_{ 0 };
+      std::size_t sq_tail_local_ = 0;
+      std::atomic<std::size_t> cq_head_{ 0 };
+      std::atomic<std::size_t> cq_tail_{ 0 };
+
+      std::atomic<std::size_t> in_flight_{ 0 };
+
+      using requests_list
+          = utils::intrusive_list<io_request, utils::double_list_links,
+                                  &io_request::free_links_>;
+      requests_list free_list_;
+
+      // The worker sleeps here, the application in cq_waiter_.
+      io_waiter sq_waiter_;
+      io_waiter cq_waiter_;
+
+      std::atomic<bool> is_running_{ false };
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_IO_RING_H_
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,298 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_IO_WAITER_H_
+#define MICRO_OS_PLUS_POSIX_IO_IO_WAITER_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <micro-os-plus/posix-io/io.h>
+
+#include <micro-os-plus/utils/lists.h>
+
+#include <ctime>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#pragma GCC diagnostic ignored "-Wsuggest-final-types"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Readiness waiter.
+     * @headerfile io-waiter.h <micro-os-plus/posix-io/io-waiter.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * A waiter is the object a thread sleeps on while waiting for
+     * one or more descriptors to become ready. While linked, it is
+     * notified every time a driver calls `io_impl::notify_events()`.
+     *
+     * This package has no RTOS dependency, so the functions that
+     * actually block (`suspend()`, `resume()` and the `critical_section`
+     * constructor/destructor) are defined weak, and are expected to
+     * be redefined by the RTOS integration layer. The default
+     * implementation does not block, `wait()` returns immediately,
+     * which turns the callers into polling loops: `select()` with
+     * a null timeout busy-waits, and any finite timeout expires
+     * at once, since there is no clock to measure it.
+     */
+    class io_waiter
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      /**
+       * @brief Scoped guard for the list of waiters.
+       *
+       * @details
+       * Since `io_impl::notify_events()` may be called from interrupt
+       * handlers, the RTOS integration should disable interrupts
+       * here (or at least lock the scheduler).
+       */
+      class critical_section
+      {
+      public:
+        critical_section (void);
+
+        /**
+         * @cond ignore
+         */
+
+        // The rule of five.
+        critical_section (const critical_section&) = delete;
+        critical_section (critical_section&&) = delete;
+        critical_section&
+        operator= (const critical_section&)
+            = delete;
+        critical_section&
+        operator= (critical_section&&)
+            = delete;
+
+        /**
+         * @endcond
+         */
+
+        ~critical_section ();
+
+      protected:
+        /**
+         * @cond ignore
+         */
+
+        unsigned int state_ = 0;
+
+        /**
+         * @endcond
+         */
+      };
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      io_waiter (void);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      io_waiter (const io_waiter&) = delete;
+      io_waiter (io_waiter&&) = delete;
+      io_waiter&
+      operator= (const io_waiter&)
+          = delete;
+      io_waiter&
+      operator= (io_waiter&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~io_waiter ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+      // Start/stop receiving notifications.
+      void
+      link (void);
+
+      void
+      unlink (void);
+
+      // Must be called before polling the descriptors; a notification
+      // that arrives after this call makes the next wait() return
+      // immediately, so no event can be lost.
+      void
+      arm (void);
+
+      // Sleep until notified or until the timeout expires. The
+      // timeout is updated with the remaining time, like nanosleep().
+      // A null timeout waits forever.
+      // Return 0 when notified, or -1 with errno ETIMEDOUT or EINTR.
+      int
+      wait (timespec* timeout);
+
+      // Wake up the thread sleeping in wait(). Safe to be called
+      // from interrupt handlers.
+      void
+      wakeup (void);
+
+      bool
+      is_signalled (void) const;
+
+      // Called, inside the critical section, for every event
+      // notified by a driver. The default calls wakeup().
+      virtual void
+      notify (io_impl& impl, io::events_t events);
+
+      // Called by io_impl::notify_events().
+      static void
+      notify_all (io_impl& impl, io::events_t events);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      // Weak, RTOS specific.
+      int
+      suspend (timespec* timeout);
+
+      void
+      resume (void);
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      volatile bool signalled_ = false;
+
+      // Opaque storage for the RTOS integration (semaphore, thread id).
+      void* rtos_data_ = nullptr;
+
+    public:
+      utils::double_list_links waiters_links_;
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+    private:
+      /**
+       * @cond ignore
+       */
+
+      // Initialised to 0 by the startup code, as the device registry.
+      using waiters_list
+          = utils::intrusive_list<io_waiter, utils::double_list_links,
+                                  &io_waiter::waiters_links_>;
+      static waiters_list waiters_list__;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    inline bool
+    io_waiter::is_signalled (void) const
+    {
+      return signalled_;
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_IO_WAITER_H_
+
+// ----------------------------------------------------------------------------
@@ -41,16 +41,31 @@
 // ----------------------------------------------------------------------------
 
 #include <micro-os-plus/posix-io/types.h>
+#include <micro-os-plus/utils/lists.h>
 #include <micro-os-plus/diag/trace.h>
 
 #include <cstddef>
 #include <cstdarg>
+#include <ctime>
+#include <atomic>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 
 // Needed for ssize_t
 #include <sys/types.h>
 
 // ----------------------------------------------------------------------------
 
+// Scattered vectors up to this size are gathered in a stack buffer
+// and transferred with a single `do_read()`/`do_write()`; 0 disables it.
+#if !defined(MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE)
+#define MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE (128)
+#endif
+
+// ----------------------------------------------------------------------------
+
 #pragma GCC diagnostic push
 
 #if defined(__clang__)
@@ -74,9 +89,16 @@ namespace micro_os_plus
 
     class io;
     class io_impl;
+    class io_request;
+
+#if defined(__cpp_impl_coroutine)
+    class io_read_awaitable;
+    class io_write_awaitable;
+#endif
 
     class file_system;
     class socket;
+    class event_poller;
 
     /**
      * @ingroup micro-os-plus-posix-io-function
@@ -90,6 +112,10 @@ namespace micro_os_plus
     io*
     vopen (const char* path, int oflag, std::va_list arguments);
 
+    int
+    select (int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds,
+            timeval* timeout);
+
     /**
      * @}
      */
@@ -143,7 +169,19 @@ namespace micro_os_plus
         block_device = 1 << 2,
         tty = 1 << 3,
         file = 1 << 4,
-        socket = 1 << 5
+        socket = 1 << 5,
+        event_poller = 1 << 6
+      };
+
+      // Readiness events, as returned by poll_events().
+      using events_t = unsigned int;
+      enum event : events_t
+      {
+        none = 0,
+        readable = 1 << 0,
+        writable = 1 << 1,
+        error = 1 << 2,
+        hangup = 1 << 3
       };
 
 #pragma GCC diagnostic pop
@@ -203,9 +241,18 @@ namespace micro_os_plus
       virtual ssize_t
       write (const void* buf, std::size_t nbyte);
 
+      virtual ssize_t
+      readv (const iovec* iov, int iovcnt);
+
       virtual ssize_t
       writev (const iovec* iov, int iovcnt);
 
+      virtual ssize_t
+      pread (void* buf, std::size_t nbyte, off_t offset);
+
+      virtual ssize_t
+      pwrite (const void* buf, std::size_t nbyte, off_t offset);
+
       int
       fcntl (int cmd, ...);
 
@@ -221,6 +268,20 @@ namespace micro_os_plus
       virtual off_t
       lseek (off_t offset, int whence);
 
+      // Non-blocking, return the events currently pending.
+      events_t
+      poll_events (void);
+
+#if defined(__cpp_impl_coroutine)
+      // co_await-able variants; the coroutine is suspended until the
+      // descriptor is ready, then the transfer is performed.
+      io_read_awaitable
+      async_read (void* buf, std::size_t nbyte);
+
+      io_write_awaitable
+      async_write (const void* buf, std::size_t nbyte);
+#endif
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -292,6 +353,75 @@ namespace micro_os_plus
 
       file_descriptor_t file_descriptor_ = no_file_descriptor;
 
+      // Managed by file_descriptors_manager::pinned_io.
+      std::atomic<unsigned int> pins_{ 0 };
+
+      // The number of descriptors referring to this open file
+      // description (more than one after dup()); managed by
+      // file_descriptors_manager.
+      std::atomic<unsigned int> descriptors_{ 0 };
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
+    /**
+     * @brief Per descriptor readiness listener.
+     * @headerfile io.h <micro-os-plus/posix-io/io.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Unlike the select() waiters, which are notified about all
+     * events, listeners are subscribed to a single `io_impl`,
+     * so notifying them costs nothing for the descriptors
+     * which did not change.
+     */
+    class io_listener
+    {
+    public:
+      io_listener (void) = default;
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      io_listener (const io_listener&) = delete;
+      io_listener (io_listener&&) = delete;
+      io_listener&
+      operator= (const io_listener&)
+          = delete;
+      io_listener&
+      operator= (io_listener&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual ~io_listener () = default;
+
+      // Called by io_impl::notify_events(), with the listeners list
+      // locked, possibly from an interrupt handler.
+      virtual void
+      notify (io_impl& impl, io::events_t events)
+          = 0;
+
+      // Called when the io is closed; the listener is already
+      // unsubscribed.
+      virtual void
+      detach (io_impl& impl)
+          = 0;
+
+      /**
+       * @cond ignore
+       */
+
+      utils::double_list_links listener_links_;
+
       /**
        * @endcond
        */
@@ -364,9 +494,18 @@ namespace micro_os_plus
       do_write (const void* buf, std::size_t nbyte)
           = 0;
 
+      virtual ssize_t
+      do_readv (const iovec* iov, int iovcnt);
+
       virtual ssize_t
       do_writev (const iovec* iov, int iovcnt);
 
+      virtual ssize_t
+      do_pread (void* buf, std::size_t nbyte, off_t offset);
+
+      virtual ssize_t
+      do_pwrite (const void* buf, std::size_t nbyte, off_t offset);
+
       virtual int
       do_vfcntl (int cmd, std::va_list arguments);
 
@@ -384,9 +523,44 @@ namespace micro_os_plus
       do_close (void)
           = 0;
 
+      // Must not block; may be called with interrupts disabled.
+      virtual io::events_t
+      do_poll_events (void);
+
+      // Start an asynchronous transfer; when done, the driver calls
+      // request.complete(). Return 0 if started, or -1 with errno
+      // ENOTSUP to have it executed synchronously, by the caller.
+      virtual int
+      do_submit (io_request& request);
+
       // ----------------------------------------------------------------------
       // Support functions.
 
+      // To be called by drivers when the readiness changes, for example
+      // from the receive interrupt. The events are recorded as pending,
+      // and the threads waiting in select() or similar are woken up.
+      void
+      notify_events (io::events_t events);
+
+      // To be called by drivers when the events are no longer pending,
+      // for example when the receive buffer was emptied.
+      void
+      clear_events (io::events_t events);
+
+      // The events recorded by notify_events() and not yet cleared.
+      io::events_t
+      pending_events (void);
+
+      void
+      subscribe (io_listener& listener);
+
+      void
+      unsubscribe (io_listener& listener);
+
+      // Unsubscribe all listeners and inform them; called on close.
+      void
+      detach_listeners (void);
+
       off_t
       offset (void);
 
@@ -397,6 +571,26 @@ namespace micro_os_plus
        * @}
        */
 
+      // ----------------------------------------------------------------------
+    protected:
+      // Count how many iovecs, starting with the first one, have their
+      // buffers adjacent in memory, thus can be transferred as one.
+      static int
+      contiguous_iovecs (const iovec* iov, int iovcnt, std::size_t* nbyte);
+
+      // Return the total size if the vector is scattered and small
+      // enough to go via the bounce buffer, 0 otherwise.
+      static std::size_t
+      bounce_iovecs (const iovec* iov, int iovcnt);
+
+      // Transfer a scattered vector with a single call, via a
+      // stack buffer of `nbyte` bytes.
+      ssize_t
+      bounce_readv (const iovec* iov, int iovcnt, std::size_t nbyte);
+
+      ssize_t
+      bounce_writev (const iovec* iov, int iovcnt, std::size_t nbyte);
+
       // ----------------------------------------------------------------------
     protected:
       /**
@@ -405,11 +599,160 @@ namespace micro_os_plus
 
       off_t offset_ = 0;
 
+      using listeners_list
+          = utils::intrusive_list<io_listener, utils::double_list_links,
+                                  &io_listener::listener_links_>;
+      listeners_list listeners_list_;
+
+      std::atomic<io::events_t> pending_events_{ io::event::none };
+
       /**
        * @endcond
        */
     };
 
+    // ========================================================================
+
+#if defined(__cpp_impl_coroutine)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Base for the coroutine awaitables.
+     * @headerfile io.h <micro-os-plus/posix-io/io.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * If the descriptor is not ready, the coroutine is suspended
+     * and the awaitable, which lives in the coroutine frame,
+     * subscribes to the io. When the driver notifies, the
+     * awaitable is queued; the coroutines are resumed later,
+     * by the scheduler thread calling `run_ready()`, never from
+     * the notification context, which may be an interrupt.
+     *
+     * The transfer in `await_resume()` is issued only after the
+     * descriptor reported the requested event, so it does not
+     * block the scheduler thread. For this to hold, the driver must
+     * record its readiness with `notify_events()`/`clear_events()`,
+     * or override `do_poll_events()`; regular files and block
+     * devices are always ready, and never suspend.
+     *
+     * This way any number of suspended coroutines share the
+     * few threads running the scheduler loop:
+     *
+     * @code{.cpp}
+     * while (true)
+     *   {
+     *     posix::io_awaitable::run_ready ();
+     *     posix::io_awaitable::wait_ready (nullptr);
+     *   }
+     * @endcode
+     */
+    class io_awaitable : public io_listener
+    {
+    public:
+      io_awaitable (class io& io, io::events_t events);
+
+      virtual ~io_awaitable () override;
+
+      bool
+      await_ready (void);
+
+      bool
+      await_suspend (std::coroutine_handle<> handle);
+
+      virtual void
+      notify (io_impl& impl, io::events_t events) override;
+
+      virtual void
+      detach (io_impl& impl) override;
+
+      // Resume the coroutines whose descriptors became ready.
+      // Return their number.
+      static int
+      run_ready (void);
+
+      // Sleep until a coroutine can be resumed.
+      // Return 0, or -1 with errno ETIMEDOUT.
+      static int
+      wait_ready (timespec* timeout);
+
+    protected:
+      void
+      enqueue (void);
+
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      class io& io_;
+      io::events_t events_;
+      std::coroutine_handle<> handle_;
+
+      // Set when the io was closed while waiting.
+      bool is_detached_ = false;
+
+      // Set, in a critical section, by the thread which owns the
+      // resume: a scheduler thread in run_ready(), or the awaiting
+      // thread itself when await_suspend() returns false.
+      bool is_claimed_ = false;
+
+    public:
+      utils::double_list_links ready_links_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    class io_read_awaitable : public io_awaitable
+    {
+    public:
+      io_read_awaitable (class io& io, void* buf, std::size_t nbyte);
+
+      ssize_t
+      await_resume (void);
+
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      void* buf_;
+      std::size_t nbyte_;
+
+      /**
+       * @endcond
+       */
+    };
+
+    class io_write_awaitable : public io_awaitable
+    {
+    public:
+      io_write_awaitable (class io& io, const void* buf, std::size_t nbyte);
+
+      ssize_t
+      await_resume (void);
+
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      const void* buf_;
+      std::size_t nbyte_;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+#endif // defined(__cpp_impl_coroutine)
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus
@@ -458,6 +801,28 @@ namespace micro_os_plus
       return impl_;
     }
 
+    inline io::events_t
+    io::poll_events (void)
+    {
+      return impl ().do_poll_events ();
+    }
+
+#if defined(__cpp_impl_coroutine)
+
+    inline io_read_awaitable
+    io::async_read (void* buf, std::size_t nbyte)
+    {
+      return io_read_awaitable{ *this, buf, nbyte };
+    }
+
+    inline io_write_awaitable
+    io::async_write (const void* buf, std::size_t nbyte)
+    {
+      return io_write_awaitable{ *this, buf, nbyte };
+    }
+
+#endif // defined(__cpp_impl_coroutine)
+
     // ========================================================================
 
     inline off_t
@@ -472,6 +837,41 @@ namespace micro_os_plus
       offset_ = offset;
     }
 
+    // ========================================================================
+
+#if defined(__cpp_impl_coroutine)
+
+    inline io_read_awaitable::io_read_awaitable (class io& io, void* buf,
+                                                 std::size_t nbyte)
+        : io_awaitable{ io, io::event::readable }, //
+          buf_ (buf), //
+          nbyte_ (nbyte)
+    {
+    }
+
+    inline ssize_t
+    io_read_awaitable::await_resume (void)
+    {
+      return io_.read (buf_, nbyte_);
+    }
+
+    inline io_write_awaitable::io_write_awaitable (class io& io,
+                                                   const void* buf,
+                                                   std::size_t nbyte)
+        : io_awaitable{ io, io::event::writable }, //
+          buf_ (buf), //
+          nbyte_ (nbyte)
+    {
+    }
+
+    inline ssize_t
+    io_write_awaitable::await_resume (void)
+    {
+      return io_.write (buf_, nbyte_);
+    }
+
+#endif // defined(__cpp_impl_coroutine)
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus
@@ -0,0 +1,310 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_RCU_H_
+#define MICRO_OS_PLUS_POSIX_IO_RCU_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <atomic>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    class io_waiter;
+
+    /**
+     * @brief Read-copy-update synchronisation static class.
+     * @headerfile rcu.h <micro-os-plus/posix-io/rcu.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * Protects the registries which are read on every `open()`, but
+     * change rarely (devices plugged, file systems mounted).
+     *
+     * Readers enter a `read_guard` and traverse the lists with
+     * acquire loads, without locks. Writers, serialised by a
+     * `write_guard`, publish fully initialised nodes with release
+     * stores; removed nodes are left intact and are reclaimed only
+     * after `synchronize()`, which waits until all readers that
+     * might still see them have left.
+     *
+     * The grace period uses two reader counters, selected by the
+     * parity of an epoch; `synchronize()` flips the epoch and waits
+     * for the old counter to drain, so new readers never delay it.
+     *
+     * Writers do not spin: `synchronize()` sleeps on an `io_waiter`,
+     * woken up by the last reader leaving, and a writer finding the
+     * guard taken sleeps for short intervals. Without an RTOS
+     * integration the waiter does not block, and both degrade to
+     * polling.
+     */
+    class rcu
+    {
+      // ----------------------------------------------------------------------
+
+    public:
+      /**
+       * @brief Scoped read-side critical section.
+       *
+       * @details
+       * Wait-free in the common case; may be nested. Pointers
+       * obtained from the registries inside the guard are valid
+       * only until the guard ends, so it must cover their use too.
+       */
+      class read_guard
+      {
+      public:
+        read_guard (void);
+
+        /**
+         * @cond ignore
+         */
+
+        // The rule of five.
+        read_guard (const read_guard&) = delete;
+        read_guard (read_guard&&) = delete;
+        read_guard&
+        operator= (const read_guard&)
+            = delete;
+        read_guard&
+        operator= (read_guard&&)
+            = delete;
+
+        /**
+         * @endcond
+         */
+
+        ~read_guard ();
+
+      protected:
+        /**
+         * @cond ignore
+         */
+
+        unsigned int index_;
+
+        /**
+         * @endcond
+         */
+      };
+
+      /**
+       * @brief Scoped writers lock.
+       */
+      class write_guard
+      {
+      public:
+        write_guard (void);
+
+        /**
+         * @cond ignore
+         */
+
+        // The rule of five.
+        write_guard (const write_guard&) = delete;
+        write_guard (write_guard&&) = delete;
+        write_guard&
+        operator= (const write_guard&)
+            = delete;
+        write_guard&
+        operator= (write_guard&&)
+            = delete;
+
+        /**
+         * @endcond
+         */
+
+        ~write_guard ();
+      };
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+      // Do not allow to create instances of this class.
+      rcu () = delete;
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      rcu (const rcu&) = delete;
+      rcu (rcu&&) = delete;
+      rcu&
+      operator= (const rcu&)
+          = delete;
+      rcu&
+      operator= (rcu&&)
+          = delete;
+
+      /**
+       * @endcond
+       */
+
+      ~rcu () = delete;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Static Member Functions
+       * @{
+       */
+
+    public:
+      // Wait for the end of a grace period. Must be called with the
+      // write guard held, and never inside a read guard.
+      static void
+      synchronize (void);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      // Sleep on the waiter for a short interval, or until woken up.
+      static void
+      pause (io_waiter& waiter);
+
+      // Called by the last reader of a grace period.
+      static void
+      wakeup_writer (void);
+
+      static std::atomic<unsigned int> epoch__;
+      static std::atomic<unsigned int> readers__[2];
+      static std::atomic_flag writer__;
+
+      // Set while a writer sleeps in synchronize().
+      static std::atomic<bool> is_synchronizing__;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    /**
+     * @details
+     * If the epoch changed between reading it and incrementing the
+     * counter, the writer may already be waiting on the other
+     * counter; step back and retry with the new epoch.
+     */
+    inline rcu::read_guard::read_guard (void)
+    {
+      while (true)
+        {
+          unsigned int epoch = epoch__.load ();
+          index_ = epoch & 1;
+          readers__[index_].fetch_add (1);
+          if (epoch__.load () == epoch)
+            {
+              break;
+            }
+          readers__[index_].fetch_sub (1);
+        }
+    }
+
+    /**
+     * @details
+     * Sequentially consistent with `synchronize()` flagging that
+     * it waits, so either the writer sees the counter drained, or
+     * the last reader sees the flag.
+     */
+    inline rcu::read_guard::~read_guard ()
+    {
+      if ((readers__[index_].fetch_sub (1) == 1)
+          && is_synchronizing__.load ())
+        {
+          wakeup_writer ();
+        }
+    }
+
+    inline rcu::write_guard::~write_guard ()
+    {
+      writer__.clear (std::memory_order_release);
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_RCU_H_
+
+// ----------------------------------------------------------------------------
@@ -42,6 +42,8 @@
 #define __posix_close close
 #define __posix_closedir closedir
 #define __posix_connect connect
+#define __posix_dup dup
+#define __posix_dup2 dup2
 #define __posix_execve execve
 #define __posix_fcntl fcntl
 #define __posix_fork fork
@@ -63,11 +65,14 @@
 #define __posix_mkdir mkdir
 #define __posix_open open
 #define __posix_opendir opendir
+#define __posix_pread pread
+#define __posix_pwrite pwrite
 #define __posix_raise raise
 #define __posix_read read
 #define __posix_readdir readdir
 #define __posix_readdir_r readdir_r
 #define __posix_readlink readlink
+#define __posix_readv readv
 #define __posix_recv recv
 #define __posix_recvfrom recvfrom
 #define __posix_recvmsg recvmsg
@@ -71,6 +71,11 @@ namespace micro_os_plus
     class socket_impl;
     class net_stack;
 
+#if defined(__cpp_impl_coroutine)
+    class socket_accept_awaitable;
+    class socket_recv_awaitable;
+#endif
+
     // ------------------------------------------------------------------------
     /**
      * @brief Network socket.
@@ -119,6 +124,9 @@ namespace micro_os_plus
        */
 
     public:
+      virtual int
+      close (void) override;
+
       virtual class socket*
       accept (sockaddr* address, socklen_t* address_len);
 
@@ -171,6 +179,16 @@ namespace micro_os_plus
       virtual int
       sockatmark (void);
 
+#if defined(__cpp_impl_coroutine)
+      // co_await-able variants, see io_awaitable.
+      socket_accept_awaitable
+      async_accept (sockaddr* address = nullptr,
+                    socklen_t* address_len = nullptr);
+
+      socket_recv_awaitable
+      async_recv (void* buffer, size_t length, int flags = 0);
+#endif
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -335,11 +353,86 @@ namespace micro_os_plus
       do_sockatmark (void)
           = 0;
 
+      // Network stacks should either override this to report the
+      // receive queue, the send window and pending connections, or
+      // call notify_events()/clear_events() when any of them changes.
+      virtual io::events_t
+      do_poll_events (void) override;
+
       /**
        * @}
        */
+
+      // ----------------------------------------------------------------------
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      bool is_listening_ = false;
+
+      /**
+       * @endcond
+       */
+    };
+
+    // ========================================================================
+
+#if defined(__cpp_impl_coroutine)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    // A listening socket becomes readable when a connection is pending.
+    class socket_accept_awaitable : public io_awaitable
+    {
+    public:
+      socket_accept_awaitable (class socket& sock, sockaddr* address,
+                               socklen_t* address_len);
+
+      class socket*
+      await_resume (void);
+
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      sockaddr* address_;
+      socklen_t* address_len_;
+
+      /**
+       * @endcond
+       */
     };
 
+    class socket_recv_awaitable : public io_awaitable
+    {
+    public:
+      socket_recv_awaitable (class socket& sock, void* buffer, size_t length,
+                             int flags);
+
+      ssize_t
+      await_resume (void);
+
+    protected:
+      /**
+       * @cond ignore
+       */
+
+      void* buffer_;
+      size_t length_;
+      int flags_;
+
+      /**
+       * @endcond
+       */
+    };
+
+#pragma GCC diagnostic pop
+
+#endif // defined(__cpp_impl_coroutine)
+
     // ========================================================================
 
     template <typename T>
@@ -569,6 +662,55 @@ namespace micro_os_plus
       return static_cast<socket_impl&> (impl_);
     }
 
+#if defined(__cpp_impl_coroutine)
+
+    inline socket_accept_awaitable
+    socket::async_accept (sockaddr* address, socklen_t* address_len)
+    {
+      return socket_accept_awaitable{ *this, address, address_len };
+    }
+
+    inline socket_recv_awaitable
+    socket::async_recv (void* buffer, size_t length, int flags)
+    {
+      return socket_recv_awaitable{ *this, buffer, length, flags };
+    }
+
+    // ========================================================================
+
+    inline socket_accept_awaitable::socket_accept_awaitable (
+        class socket& sock, sockaddr* address, socklen_t* address_len)
+        : io_awaitable{ sock, io::event::readable }, //
+          address_ (address), //
+          address_len_ (address_len)
+    {
+    }
+
+    inline class socket*
+    socket_accept_awaitable::await_resume (void)
+    {
+      return static_cast<class socket&> (io_).accept (address_, address_len_);
+    }
+
+    inline socket_recv_awaitable::socket_recv_awaitable (class socket& sock,
+                                                         void* buffer,
+                                                         size_t length,
+                                                         int flags)
+        : io_awaitable{ sock, io::event::readable }, //
+          buffer_ (buffer), //
+          length_ (length), //
+          flags_ (flags)
+    {
+    }
+
+    inline ssize_t
+    socket_recv_awaitable::await_resume (void)
+    {
+      return static_cast<class socket&> (io_).recv (buffer_, length_, flags_);
+    }
+
+#endif // defined(__cpp_impl_coroutine)
+
     // ========================================================================
 
     template <typename T>
@@ -0,0 +1,381 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_POSIX_IO_STATIC_NAME_TABLE_H_
+#define MICRO_OS_PLUS_POSIX_IO_STATIC_NAME_TABLE_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#if defined(HAVE_MICRO_OS_PLUS_CONFIG_H)
+#include <micro-os-plus/config.h>
+#endif // HAVE_MICRO_OS_PLUS_CONFIG_H
+
+// ----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    template <typename T>
+    struct static_name_entry
+    {
+      const char* name;
+      T* object;
+    };
+
+    /**
+     * @brief Read-only view of a `static_name_table`.
+     * @headerfile static-name-table.h
+     * <micro-os-plus/posix-io/static-name-table.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * The view does not depend on the number of entries, so it can
+     * be returned by non-template functions.
+     */
+    template <typename T>
+    class static_name_view
+    {
+    public:
+      using value_type = T;
+      using entry_type = static_name_entry<T>;
+      using hash_t = std::uint32_t;
+
+      // FNV-1a, with the offset basis altered by the seed.
+      static constexpr hash_t
+      hash_start (hash_t seed);
+
+      static constexpr hash_t
+      hash_step (hash_t hash, char c);
+
+      static constexpr hash_t
+      hash (hash_t seed, const char* name, std::size_t length);
+
+      // The hash of the name must have been computed with the seed.
+      value_type*
+      find (hash_t hash, const char* name, std::size_t length) const;
+
+      value_type*
+      find (const char* name, std::size_t length) const;
+
+      value_type*
+      find (const char* name) const;
+
+      // ----------------------------------------------------------------------
+
+      // Public, to allow aggregate initialisation in constant
+      // expressions.
+      const entry_type* entries;
+      // Entry index + 1; 0 for empty slots.
+      const std::uint16_t* index;
+      hash_t mask;
+      hash_t seed;
+    };
+
+    /**
+     * @brief Perfect-hashed table of names, built at compile time.
+     * @headerfile static-name-table.h
+     * <micro-os-plus/posix-io/static-name-table.h>
+     * @ingroup micro-os-plus-posix-io-base
+     *
+     * @details
+     * The constructor sorts the entries by name and searches for a
+     * seed which maps all names to distinct slots; declared
+     * `constexpr`, all this is done by the compiler, and the table
+     * is placed in read-only memory. A lookup is one hash, one slot
+     * and one string comparison.
+     *
+     * Duplicate names fail the compilation.
+     *
+     * @par Example
+     *
+     * @code{.cpp}
+     * constexpr posix::static_name_table<posix::device, 2> devices{ {
+     *     { "tty0", &tty0 }, //
+     *     { "sda", &sda } //
+     * } };
+     * constexpr auto devices_view = devices.view ();
+     * @endcode
+     */
+    template <typename T, std::size_t N>
+    class static_name_table
+    {
+    public:
+      using value_type = T;
+      using entry_type = static_name_entry<T>;
+      using view_type = static_name_view<T>;
+      using hash_t = typename view_type::hash_t;
+
+      static_assert (N > 0, "The table must not be empty");
+      static_assert (N < 0x8000, "Too many entries");
+
+      // At least twice the number of entries, to find a seed fast.
+      static constexpr std::size_t slots = [] {
+        std::size_t n = 1;
+        while (n < 2 * N)
+          {
+            n <<= 1;
+          }
+        return n;
+      }();
+
+      constexpr static_name_table (const entry_type (&entries)[N]);
+
+      constexpr view_type
+      view (void) const;
+
+      // ----------------------------------------------------------------------
+
+      // Public, to allow the table to be a literal type.
+      entry_type entries_[N]{};
+      std::uint16_t index_[slots]{};
+      hash_t seed_ = 0;
+
+    protected:
+      static constexpr int
+      compare (const char* a, const char* b);
+
+      static constexpr std::size_t
+      length (const char* s);
+
+      constexpr bool
+      try_seed (hash_t seed);
+    };
+
+    // Not constexpr; called when the table cannot be built, it makes
+    // the compilation fail for constexpr tables.
+    [[noreturn]] inline void
+    static_name_table_error (void)
+    {
+      std::abort ();
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+// ===== Inline & template implementations ====================================
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    template <typename T>
+    constexpr typename static_name_view<T>::hash_t
+    static_name_view<T>::hash_start (hash_t seed)
+    {
+      return 2166136261u ^ (seed * 0x9E3779B9u);
+    }
+
+    template <typename T>
+    constexpr typename static_name_view<T>::hash_t
+    static_name_view<T>::hash_step (hash_t hash, char c)
+    {
+      return (hash ^ static_cast<unsigned char> (c)) * 16777619u;
+    }
+
+    template <typename T>
+    constexpr typename static_name_view<T>::hash_t
+    static_name_view<T>::hash (hash_t seed, const char* name,
+                               std::size_t length)
+    {
+      hash_t h = hash_start (seed);
+      for (std::size_t i = 0; i < length; ++i)
+        {
+          h = hash_step (h, name[i]);
+        }
+      return h;
+    }
+
+    template <typename T>
+    inline T*
+    static_name_view<T>::find (hash_t hash, const char* name,
+                               std::size_t length) const
+    {
+      std::uint16_t i = index[hash & mask];
+      if (i == 0)
+        {
+          return nullptr;
+        }
+
+      const entry_type& e = entries[i - 1];
+      if ((std::strncmp (e.name, name, length) != 0)
+          || (e.name[length] != '\0'))
+        {
+          return nullptr;
+        }
+      return e.object;
+    }
+
+    template <typename T>
+    inline T*
+    static_name_view<T>::find (const char* name, std::size_t length) const
+    {
+      return find (hash (seed, name, length), name, length);
+    }
+
+    template <typename T>
+    inline T*
+    static_name_view<T>::find (const char* name) const
+    {
+      return find (name, std::strlen (name));
+    }
+
+    // ========================================================================
+
+    template <typename T, std::size_t N>
+    constexpr static_name_table<T, N>::static_name_table (
+        const entry_type (&entries)[N])
+    {
+      // Insertion sort by name.
+      for (std::size_t i = 0; i < N; ++i)
+        {
+          std::size_t j = i;
+          while ((j > 0) && (compare (entries_[j - 1].name, entries[i].name)
+                             > 0))
+            {
+              entries_[j] = entries_[j - 1];
+              --j;
+            }
+          entries_[j] = entries[i];
+        }
+
+      for (std::size_t i = 1; i < N; ++i)
+        {
+          if (compare (entries_[i - 1].name, entries_[i].name) == 0)
+            {
+              // Duplicate name.
+              static_name_table_error ();
+            }
+        }
+
+      for (hash_t seed = 0; seed < 0x10000; ++seed)
+        {
+          if (try_seed (seed))
+            {
+              return;
+            }
+        }
+
+      // No perfect hash found.
+      static_name_table_error ();
+    }
+
+    template <typename T, std::size_t N>
+    constexpr typename static_name_table<T, N>::view_type
+    static_name_table<T, N>::view (void) const
+    {
+      return view_type{ entries_, index_, static_cast<hash_t> (slots - 1),
+                        seed_ };
+    }
+
+    template <typename T, std::size_t N>
+    constexpr int
+    static_name_table<T, N>::compare (const char* a, const char* b)
+    {
+      while ((*a != '\0') && (*a == *b))
+        {
+          ++a;
+          ++b;
+        }
+      return static_cast<int> (static_cast<unsigned char> (*a))
+             - static_cast<int> (static_cast<unsigned char> (*b));
+    }
+
+    template <typename T, std::size_t N>
+    constexpr std::size_t
+    static_name_table<T, N>::length (const char* s)
+    {
+      std::size_t n = 0;
+      while (s[n] != '\0')
+        {
+          ++n;
+        }
+      return n;
+    }
+
+    template <typename T, std::size_t N>
+    constexpr bool
+    static_name_table<T, N>::try_seed (hash_t seed)
+    {
+      for (std::size_t k = 0; k < slots; ++k)
+        {
+          index_[k] = 0;
+        }
+
+      for (std::size_t i = 0; i < N; ++i)
+        {
+          const char* name = entries_[i].name;
+          std::size_t k
+              = view_type::hash (seed, name, length (name)) & (slots - 1);
+          if (index_[k] != 0)
+            {
+              return false;
+            }
+          index_[k] = static_cast<std::uint16_t> (i + 1);
+        }
+
+      seed_ = seed;
+      return true;
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+
+#endif // __cplusplus
+
+// ----------------------------------------------------------------------------
+
+#endif // MICRO_OS_PLUS_POSIX_IO_STATIC_NAME_TABLE_H_
+
+// ----------------------------------------------------------------------------
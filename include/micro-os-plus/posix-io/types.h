@@ -103,6 +103,11 @@ extern "C"
   __posix_connect (int socket, const struct sockaddr* address,
                    socklen_t address_len);
 
+  // http://pubs.opengroup.org/onlinepubs/9699919799/functions/dup.html
+  int __attribute__ ((weak)) __posix_dup (int fildes);
+
+  int __attribute__ ((weak)) __posix_dup2 (int fildes, int fildes2);
+
   int __attribute__ ((weak))
   __posix_execve (const char* path, char* const argv[], char* const envp[]);
 
@@ -186,6 +191,14 @@ extern "C"
 
   DIR* __attribute__ ((weak)) __posix_opendir (const char* dirname);
 
+  // http://pubs.opengroup.org/onlinepubs/9699919799/functions/pread.html
+  ssize_t __attribute__ ((weak))
+  __posix_pread (int fildes, void* buf, size_t nbyte, off_t offset);
+
+  // http://pubs.opengroup.org/onlinepubs/9699919799/functions/pwrite.html
+  ssize_t __attribute__ ((weak))
+  __posix_pwrite (int fildes, const void* buf, size_t nbyte, off_t offset);
+
   int __attribute__ ((weak)) __posix_raise (int sig);
 
   ssize_t __attribute__ ((weak))
@@ -199,6 +212,10 @@ extern "C"
   ssize_t __attribute__ ((weak))
   __posix_readlink (const char* path, char* buf, size_t bufsize);
 
+  // http://pubs.opengroup.org/onlinepubs/9699919799/functions/readv.html
+  ssize_t __attribute__ ((weak))
+  __posix_readv (int fildes, const struct iovec* iov, int iovcnt);
+
   ssize_t __attribute__ ((weak))
   __posix_recv (int socket, void* buffer, size_t length, int flags);
 
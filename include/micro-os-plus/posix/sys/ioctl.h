@@ -111,6 +111,9 @@
 #define _IOWR(type, nr, size) \
   _IOC (_IOC_READ | _IOC_WRITE, (type), (nr), (_IOC_TYPECHECK (size)))
 
+#define BLKRASET _IO (0x12, 98) /* set read ahead for block device */
+#define BLKRAGET _IO (0x12, 99) /* get current read ahead setting */
+
 /* 108-111 have been used for various private purposes. */
 
 #define BLKSSZGET _IO (0x12, 104) /* get block logical device sector size */
@@ -119,6 +122,9 @@
 #define BLKPBSZGET \
   _IO (0x12, 123) /* get block physical device sector size \
                    */
+#define BLKDISCARD _IO (0x12, 119) /* discard range (u64 [2] arg) */
+#define BLKSECDISCARD _IO (0x12, 125) /* securely discard range */
+#define BLKZEROOUT _IO (0x12, 127) /* zero range (u64 [2] arg) */
 
 // ----------------------------------------------------------------------------
 
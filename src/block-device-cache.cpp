@@ -0,0 +1,591 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/block-device-cache.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cstring>
+#include <cassert>
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    block_device_cache::block_device_cache (block_device_impl& impl,
+                                            const char* name)
+        : block_device{ impl, name }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache::%s(\"%s\")=@%p\n", __func__, name_,
+                     this);
+#endif
+    }
+
+    block_device_cache::~block_device_cache ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache::%s() @%p %s\n", __func__, this,
+                     name_);
+#endif
+    }
+
+    // ========================================================================
+
+    /**
+     * @details
+     * The buffer descriptors are allocated here; the block data is
+     * allocated when the device is opened, since the block size is
+     * known only then.
+     */
+    block_device_cache_impl::block_device_cache_impl (block_device& parent,
+                                                      std::size_t buffers)
+        : parent_ (parent), //
+          buffers_count_ (buffers)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%u)=@%p\n", __func__,
+                     buffers, this);
+#endif
+
+      assert (buffers >= 2);
+
+      in_max_ = (buffers >= 4) ? buffers / 4 : 1;
+      ghosts_max_ = buffers / 2;
+
+      buffers_ = new buffer[buffers] ();
+      ghosts_ = new blknum_t[ghosts_max_];
+
+      std::size_t n = 1;
+      while (n < buffers)
+        {
+          n <<= 1;
+        }
+      buckets_ = new buffer*[n];
+      buckets_mask_ = n - 1;
+
+      invalidate ();
+    }
+
+    block_device_cache_impl::~block_device_cache_impl ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s() @%p\n", __func__, this);
+#endif
+
+      delete[] data_;
+      delete[] buckets_;
+      delete[] ghosts_;
+      delete[] buffers_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    block_device_cache_impl::do_vioctl (int request, std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%d) @%p\n", __func__,
+                     request, this);
+#endif
+
+      return parent_.vioctl (request, arguments);
+    }
+
+    int
+    block_device_cache_impl::do_vopen (const char* path, int oflag,
+                                       std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%d) @%p\n", __func__, oflag,
+                     this);
+#endif
+
+      int ret = parent_.vopen (path, oflag, arguments);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      // Inherit from parent; the media may have changed.
+      block_logical_size_bytes_ = parent_.block_logical_size_bytes ();
+      block_physical_size_bytes_ = parent_.block_physical_size_bytes ();
+      num_blocks_ = parent_.blocks ();
+
+      if (block_logical_size_bytes_ != data_block_size_)
+        {
+          delete[] data_;
+          data_ = new std::uint8_t[buffers_count_ * block_logical_size_bytes_];
+          data_block_size_ = block_logical_size_bytes_;
+
+          for (std::size_t i = 0; i < buffers_count_; ++i)
+            {
+              buffers_[i].data = data_ + i * data_block_size_;
+            }
+        }
+
+      return ret;
+    }
+
+    /**
+     * @details
+     * Cached blocks are copied from RAM; each run of missing blocks
+     * is read from the parent with a single request, directly into
+     * the caller buffer, and then copied into the cache.
+     */
+    ssize_t
+    block_device_cache_impl::do_read_block (void* buf, blknum_t blknum,
+                                            std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%p, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      auto* p = static_cast<std::uint8_t*> (buf);
+      const std::size_t size = block_logical_size_bytes_;
+
+      std::size_t done = 0;
+      while (done < nblocks)
+        {
+          auto* b = find (blknum + done);
+          if (b != nullptr)
+            {
+              ++hits_;
+              touch (b);
+              std::memcpy (p + done * size, b->data, size);
+              ++done;
+              continue;
+            }
+
+          std::size_t n = 1;
+          while ((done + n < nblocks) && (find (blknum + done + n) == nullptr))
+            {
+              ++n;
+            }
+          misses_ += n;
+
+          ssize_t ret = parent_.read_block (p + done * size, blknum + done, n);
+          if (ret < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+
+          auto count = static_cast<std::size_t> (ret);
+          for (std::size_t i = 0; i < count; ++i)
+            {
+              auto* nb = allocate (blknum + done + i);
+              if (nb != nullptr)
+                {
+                  std::memcpy (nb->data, p + (done + i) * size, size);
+                }
+            }
+
+          done += count;
+          if (count < n)
+            {
+              break;
+            }
+        }
+
+      return static_cast<ssize_t> (done);
+    }
+
+    /**
+     * @details
+     * Short writes only update the cache and mark the blocks dirty.
+     * Writes longer than the in queue would only evict themselves,
+     * so they are passed to the parent with a single request, and
+     * the cached copies, if any, are updated.
+     */
+    ssize_t
+    block_device_cache_impl::do_write_block (const void* buf, blknum_t blknum,
+                                             std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%p, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      auto* p = static_cast<const std::uint8_t*> (buf);
+      const std::size_t size = block_logical_size_bytes_;
+
+      if (nblocks > in_max_)
+        {
+          ssize_t ret = parent_.write_block (buf, blknum, nblocks);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          for (std::size_t i = 0; i < static_cast<std::size_t> (ret); ++i)
+            {
+              auto* b = find (blknum + i);
+              if (b != nullptr)
+                {
+                  std::memcpy (b->data, p + i * size, size);
+                  b->dirty = false;
+                }
+            }
+          return ret;
+        }
+
+      for (std::size_t i = 0; i < nblocks; ++i)
+        {
+          auto* b = find (blknum + i);
+          if (b != nullptr)
+            {
+              touch (b);
+            }
+          else
+            {
+              b = allocate (blknum + i);
+              if (b == nullptr)
+                {
+                  return (i > 0) ? static_cast<ssize_t> (i) : -1;
+                }
+            }
+
+          std::memcpy (b->data, p + i * size, size);
+          b->dirty = true;
+        }
+
+      return static_cast<ssize_t> (nblocks);
+    }
+
+    /**
+     * @details
+     * Once the parent accepted the discard, the cached copies are
+     * dropped, even if dirty, since writing them back would defeat
+     * it. If the parent refuses, for example with `ENOTSUP`, they
+     * are kept, so writes not yet synchronised are not lost.
+     */
+    int
+    block_device_cache_impl::do_discard (blknum_t blknum, std::size_t nblocks,
+                                         bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%u, %u, %d) @%p\n",
+                     __func__, blknum, nblocks, secure, this);
+#endif
+
+      int ret = parent_.discard_blocks (blknum, nblocks, secure);
+      if (ret == 0)
+        {
+          drop (blknum, nblocks);
+        }
+      return ret;
+    }
+
+    /**
+     * @details
+     * As for discards, the cached copies are dropped only if the
+     * parent zeroed the blocks.
+     */
+    int
+    block_device_cache_impl::do_write_zeroes (blknum_t blknum,
+                                              std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s(%u, %u) @%p\n", __func__,
+                     blknum, nblocks, this);
+#endif
+
+      int ret = parent_.write_zeroes (blknum, nblocks);
+      if (ret == 0)
+        {
+          drop (blknum, nblocks);
+        }
+      return ret;
+    }
+
+    void
+    block_device_cache_impl::do_sync (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s() @%p\n", __func__, this);
+#endif
+
+      flush ();
+      parent_.sync ();
+    }
+
+    int
+    block_device_cache_impl::do_close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_CACHE)
+      trace::printf ("block_device_cache_impl::%s() @%p\n", __func__, this);
+#endif
+
+      int ret = flush ();
+
+      // The media may be changed while closed.
+      invalidate ();
+
+      int ret2 = parent_.close ();
+      return (ret < 0) ? ret : ret2;
+    }
+
+    // ------------------------------------------------------------------------
+
+    block_device_cache_impl::buffer*
+    block_device_cache_impl::find (blknum_t blknum)
+    {
+      auto* b = buckets_[blknum & buckets_mask_];
+      while ((b != nullptr) && (b->blknum != blknum))
+        {
+          b = b->hash_next;
+        }
+      return b;
+    }
+
+    /**
+     * @details
+     * The victim is the oldest block in the in queue if that queue
+     * is over its share, otherwise the least recently used block
+     * in the main queue. Blocks evicted from the in queue are
+     * remembered, so a second reference soon after promotes them
+     * straight to the main queue.
+     */
+    block_device_cache_impl::buffer*
+    block_device_cache_impl::allocate (blknum_t blknum)
+    {
+      buffer* b;
+      if (!free_list_.empty ())
+        {
+          b = free_list_.unlink_head ();
+        }
+      else
+        {
+          bool from_in = (in_count_ > in_max_) || main_list_.empty ();
+          b = from_in ? in_list_.unlink_head () : main_list_.unlink_head ();
+
+          if (b->dirty && (write_back (b) < 0))
+            {
+              // Keep it, at the end of its queue.
+              (from_in ? in_list_ : main_list_).link (*b);
+              return nullptr;
+            }
+
+          if (from_in)
+            {
+              --in_count_;
+              remember (b->blknum);
+            }
+
+          auto** link = &buckets_[b->blknum & buckets_mask_];
+          while (*link != b)
+            {
+              link = &(*link)->hash_next;
+            }
+          *link = b->hash_next;
+        }
+
+      b->blknum = blknum;
+      b->dirty = false;
+      auto& head = buckets_[blknum & buckets_mask_];
+      b->hash_next = head;
+      head = b;
+
+      if (forget (blknum))
+        {
+          b->where = queue::main;
+          main_list_.link (*b);
+        }
+      else
+        {
+          b->where = queue::in;
+          in_list_.link (*b);
+          ++in_count_;
+        }
+
+      return b;
+    }
+
+    void
+    block_device_cache_impl::touch (buffer* b)
+    {
+      // Hits in the in queue do not count, they are usually
+      // correlated references, like the header and the body of
+      // a record in the same block.
+      if (b->where == queue::main)
+        {
+          b->links.unlink ();
+          main_list_.link (*b);
+        }
+    }
+
+    int
+    block_device_cache_impl::write_back (buffer* b)
+    {
+      ssize_t ret = parent_.write_block (b->data, b->blknum, 1);
+      if (ret != 1)
+        {
+          if (ret >= 0)
+            {
+              errno = EIO;
+            }
+          return -1;
+        }
+
+      b->dirty = false;
+      return 0;
+    }
+
+    int
+    block_device_cache_impl::flush (void)
+    {
+      int ret = 0;
+      for (std::size_t i = 0; i < buffers_count_; ++i)
+        {
+          if (buffers_[i].dirty && (write_back (&buffers_[i]) < 0))
+            {
+              ret = -1;
+            }
+        }
+      return ret;
+    }
+
+    void
+    block_device_cache_impl::invalidate (void)
+    {
+      for (std::size_t i = 0; i < buffers_count_; ++i)
+        {
+          auto& b = buffers_[i];
+          // Free buffers are linked too, in the free list.
+          if (b.links.linked ())
+            {
+              b.links.unlink ();
+            }
+          b.where = queue::none;
+          b.dirty = false;
+          b.hash_next = nullptr;
+        }
+
+      for (std::size_t i = 0; i < buffers_count_; ++i)
+        {
+          free_list_.link (buffers_[i]);
+        }
+
+      for (std::size_t i = 0; i <= buckets_mask_; ++i)
+        {
+          buckets_[i] = nullptr;
+        }
+
+      in_count_ = 0;
+      ghosts_head_ = 0;
+      ghosts_count_ = 0;
+    }
+
+    void
+    block_device_cache_impl::drop (blknum_t blknum, std::size_t nblocks)
+    {
+      // The range may be large, walk the buffers, not the blocks.
+      for (std::size_t i = 0; i < buffers_count_; ++i)
+        {
+          auto* b = &buffers_[i];
+          if ((b->where == queue::none) || (b->blknum < blknum)
+              || (b->blknum >= blknum + nblocks))
+            {
+              continue;
+            }
+
+          auto** link = &buckets_[b->blknum & buckets_mask_];
+          while (*link != b)
+            {
+              link = &(*link)->hash_next;
+            }
+          *link = b->hash_next;
+
+          if (b->where == queue::in)
+            {
+              --in_count_;
+            }
+          b->links.unlink ();
+          b->where = queue::none;
+          b->dirty = false;
+          free_list_.link (*b);
+        }
+    }
+
+    void
+    block_device_cache_impl::remember (blknum_t blknum)
+    {
+      if (ghosts_max_ == 0)
+        {
+          return;
+        }
+
+      // Overwrite the oldest if full.
+      ghosts_[(ghosts_head_ + ghosts_count_) % ghosts_max_] = blknum;
+      if (ghosts_count_ < ghosts_max_)
+        {
+          ++ghosts_count_;
+        }
+      else
+        {
+          ghosts_head_ = (ghosts_head_ + 1) % ghosts_max_;
+        }
+    }
+
+    bool
+    block_device_cache_impl::forget (blknum_t blknum)
+    {
+      // A short ring, a linear search is cheaper than a hash.
+      for (std::size_t i = 0; i < ghosts_count_; ++i)
+        {
+          std::size_t k = (ghosts_head_ + i) % ghosts_max_;
+          if (ghosts_[k] == blknum)
+            {
+              // Fill the hole with the oldest, and drop it.
+              ghosts_[k] = ghosts_[ghosts_head_];
+              ghosts_head_ = (ghosts_head_ + 1) % ghosts_max_;
+              --ghosts_count_;
+              return true;
+            }
+        }
+      return false;
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,1147 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/block-device-ftl.h>
+#include <micro-os-plus/posix-io/crc32.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cstring>
+#include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    block_device_ftl::block_device_ftl (block_device_impl& impl,
+                                        const char* name)
+        : block_device{ impl, name }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl::%s(\"%s\")=@%p\n", __func__, name_,
+                     this);
+#endif
+    }
+
+    block_device_ftl::~block_device_ftl ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl::%s() @%p %s\n", __func__, this, name_);
+#endif
+    }
+
+    int
+    block_device_ftl::collect (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl::%s() @%p\n", __func__, this);
+#endif
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      return impl ().collect ();
+    }
+
+    // ========================================================================
+
+    block_device_ftl_impl::block_device_ftl_impl (block_device& parent,
+                                                  std::size_t spare)
+        : parent_ (parent), //
+          spare_ (spare)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%u)=@%p\n", __func__, spare,
+                     this);
+#endif
+
+      assert (spare >= 2);
+    }
+
+    block_device_ftl_impl::~block_device_ftl_impl ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s() @%p\n", __func__, this);
+#endif
+
+      delete[] page_buffer_;
+      delete[] journal_page_;
+      delete[] states_;
+      delete[] erase_counts_;
+      delete[] valid_;
+      delete[] owners_;
+      delete[] map_;
+    }
+
+    // ------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    int
+    block_device_ftl_impl::do_vioctl (int request, std::va_list arguments)
+    {
+      errno = ENOSYS;
+      return -1;
+    }
+
+#pragma GCC diagnostic pop
+
+    /**
+     * @details
+     * The first open allocates the tables and mounts the journal;
+     * with `O_TRUNC`, the parent is formatted instead, and all the
+     * data is lost.
+     */
+    int
+    block_device_ftl_impl::do_vopen (const char* path, int oflag,
+                                     std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%d) @%p\n", __func__, oflag,
+                     this);
+#endif
+
+      int ret = parent_.vopen (path, oflag, arguments);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      int res = configure ();
+      if (res == 0)
+        {
+          res = ((oflag & O_TRUNC) != 0) ? format () : mount ();
+        }
+      if (res < 0)
+        {
+          int err = errno;
+          parent_.close ();
+          num_blocks_ = 0;
+          errno = err;
+          return -1;
+        }
+
+      return ret;
+    }
+
+    /**
+     * @details
+     * Consecutive logical blocks written together are usually in
+     * consecutive pages, and are read with a single request.
+     * Blocks never written, or discarded, read as zeroes.
+     */
+    ssize_t
+    block_device_ftl_impl::do_read_block (void* buf, blknum_t blknum,
+                                          std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%p, %u, %u) @%p\n", __func__,
+                     buf, blknum, nblocks, this);
+#endif
+
+      auto* p = static_cast<std::uint8_t*> (buf);
+
+      std::size_t done = 0;
+      while (done < nblocks)
+        {
+          std::uint32_t page = map_[blknum + done];
+          if (page == none__)
+            {
+              std::memset (p + done * page_size_, 0, page_size_);
+              ++done;
+              continue;
+            }
+
+          std::size_t n = 1;
+          while ((done + n < nblocks) && (map_[blknum + done + n] == page + n))
+            {
+              ++n;
+            }
+
+          ssize_t ret
+              = parent_.read_block (p + done * page_size_, data_page (page), n);
+          if (ret < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+
+          done += static_cast<std::size_t> (ret);
+          if (static_cast<std::size_t> (ret) < n)
+            {
+              break;
+            }
+        }
+
+      return static_cast<ssize_t> (done);
+    }
+
+    /**
+     * @details
+     * The blocks are programmed in the free pages of the current
+     * erase block, as many as fit with a single request.
+     */
+    ssize_t
+    block_device_ftl_impl::do_write_block (const void* buf, blknum_t blknum,
+                                           std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%p, %u, %u) @%p\n", __func__,
+                     buf, blknum, nblocks, this);
+#endif
+
+      auto* p = static_cast<const std::uint8_t*> (buf);
+
+      std::size_t done = 0;
+      while (done < nblocks)
+        {
+          if (allocate () < 0)
+            {
+              break;
+            }
+
+          std::size_t n = pages_per_block_ - current_next_;
+          if (n > nblocks - done)
+            {
+              n = nblocks - done;
+            }
+          auto first = static_cast<std::uint32_t> (current_ * pages_per_block_
+                                                   + current_next_);
+
+          ssize_t ret = parent_.write_block (p + done * page_size_,
+                                             data_page (first), n);
+          // Failed pages may be partly programmed; skip them all.
+          current_next_ += n;
+          if (ret < 0)
+            {
+              break;
+            }
+
+          auto count = static_cast<std::size_t> (ret);
+          for (std::size_t i = 0; i < count; ++i)
+            {
+              auto lbn = static_cast<std::uint32_t> (blknum + done + i);
+              remap (lbn, first + static_cast<std::uint32_t> (i));
+              journal_record (lbn, first + static_cast<std::uint32_t> (i));
+            }
+
+          done += count;
+          if (count < n)
+            {
+              break;
+            }
+        }
+
+      return (done > 0) ? static_cast<ssize_t> (done) : -1;
+    }
+
+    /**
+     * @details
+     * Discarded blocks are only unmapped; their pages are erased
+     * when the collector reclaims the erase block, so a secure
+     * discard is not supported.
+     */
+    int
+    block_device_ftl_impl::do_discard (blknum_t blknum, std::size_t nblocks,
+                                       bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%u, %u, %d) @%p\n", __func__,
+                     blknum, nblocks, secure, this);
+#endif
+
+      if (secure)
+        {
+          errno = ENOTSUP;
+          return -1;
+        }
+
+      for (std::size_t i = 0; i < nblocks; ++i)
+        {
+          auto lbn = static_cast<std::uint32_t> (blknum + i);
+          if (map_[lbn] != none__)
+            {
+              remap (lbn, none__);
+              if (journal_record (lbn, none__) < 0)
+                {
+                  return -1;
+                }
+            }
+        }
+      return 0;
+    }
+
+    int
+    block_device_ftl_impl::do_write_zeroes (blknum_t blknum,
+                                            std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%u, %u) @%p\n", __func__,
+                     blknum, nblocks, this);
+#endif
+
+      // Unmapped blocks read as zeroes.
+      return do_discard (blknum, nblocks, false);
+    }
+
+    void
+    block_device_ftl_impl::do_sync (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s() @%p\n", __func__, this);
+#endif
+
+      journal_flush ();
+      parent_.sync ();
+    }
+
+    int
+    block_device_ftl_impl::do_close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s() @%p\n", __func__, this);
+#endif
+
+      int ret = journal_flush ();
+
+      int ret2 = parent_.close ();
+      return (ret < 0) ? ret : ret2;
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * The journal areas are sized to hold two snapshots of the
+     * largest map, so at least half of each area is left for the
+     * changes between checkpoints.
+     */
+    int
+    block_device_ftl_impl::configure (void)
+    {
+      std::size_t page_size = parent_.block_logical_size_bytes ();
+      std::size_t block_size = parent_.block_physical_size_bytes ();
+
+      if ((page_size < sizeof (journal_header) + 64)
+          || (block_size < 2 * page_size) || ((block_size % page_size) != 0))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      std::size_t pages_per_block = block_size / page_size;
+      std::size_t blocks = parent_.blocks () / pages_per_block;
+      std::size_t entries_per_page
+          = (page_size - sizeof (journal_header)) / (2 * sizeof (std::uint32_t));
+
+      std::size_t journal_blocks = 1;
+      std::size_t data_blocks;
+      std::size_t logical;
+      while (true)
+        {
+          if (blocks <= 2 * journal_blocks + spare_ + 1)
+            {
+              errno = ENOSPC;
+              return -1;
+            }
+          data_blocks = blocks - 2 * journal_blocks;
+          logical = (data_blocks - spare_) * pages_per_block;
+
+          std::size_t snapshot_pages
+              = (logical + data_blocks + entries_per_page - 1)
+                / entries_per_page;
+          if (journal_blocks * pages_per_block >= 2 * snapshot_pages + 1)
+            {
+              break;
+            }
+          ++journal_blocks;
+        }
+
+      if ((page_size != page_size_) || (data_blocks != data_blocks_)
+          || (pages_per_block != pages_per_block_))
+        {
+          delete[] page_buffer_;
+          delete[] journal_page_;
+          delete[] states_;
+          delete[] erase_counts_;
+          delete[] valid_;
+          delete[] owners_;
+          delete[] map_;
+
+          map_ = new std::uint32_t[logical];
+          owners_ = new std::uint32_t[data_blocks * pages_per_block];
+          valid_ = new std::uint32_t[data_blocks];
+          erase_counts_ = new std::uint32_t[data_blocks];
+          states_ = new state[data_blocks];
+          journal_page_ = new std::uint8_t[page_size];
+          page_buffer_ = new std::uint8_t[page_size];
+        }
+
+      page_size_ = page_size;
+      pages_per_block_ = pages_per_block;
+      journal_blocks_ = journal_blocks;
+      data_first_ = 2 * journal_blocks;
+      data_blocks_ = data_blocks;
+      entries_per_page_ = entries_per_page;
+
+      block_logical_size_bytes_ = page_size;
+      // Blocks are rewritable one by one.
+      block_physical_size_bytes_ = page_size;
+      num_blocks_ = logical;
+
+      erases_ = 0;
+
+      return 0;
+    }
+
+    /**
+     * @details
+     * The area with the most recent complete snapshot is used;
+     * if its last page was torn by a power failure, it cannot be
+     * programmed again, so the state is saved to the other area.
+     *
+     * Without a valid snapshot, only a blank parent is formatted;
+     * anything else may be data which could not be read back, so
+     * the open fails, and the parent is left untouched.
+     */
+    int
+    block_device_ftl_impl::mount (void)
+    {
+      journal_header h[2];
+      bool valid[2];
+      for (std::size_t a = 0; a < 2; ++a)
+        {
+          valid[a] = journal_read (a, 0, &h[a])
+                     && ((h[a].flags & snapshot_flag__) != 0);
+        }
+
+      std::size_t first = 0;
+      if (valid[0] && valid[1])
+        {
+          first = (static_cast<std::int32_t> (h[1].seq - h[0].seq) > 0) ? 1 : 0;
+        }
+      else if (valid[1])
+        {
+          first = 1;
+        }
+
+      bool mounted = false;
+      for (std::size_t k = 0; (k < 2) && !mounted; ++k)
+        {
+          std::size_t a = (k == 0) ? first : 1 - first;
+          mounted = valid[a] && replay (a);
+        }
+
+      if (!mounted)
+        {
+          if (!is_blank (0) || !is_blank (1))
+            {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+              trace::printf ("block_device_ftl_impl::%s() no journal\n",
+                             __func__);
+#endif
+              errno = EIO;
+              return -1;
+            }
+
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+          trace::printf ("block_device_ftl_impl::%s() format\n", __func__);
+#endif
+          return format ();
+        }
+
+      rebuild ();
+
+      if ((journal_next_ == area_pages ())
+          || !is_erased (area_page (journal_area_, journal_next_)))
+        {
+          return checkpoint ();
+        }
+      return 0;
+    }
+
+    int
+    block_device_ftl_impl::format (void)
+    {
+      for (std::size_t i = 0; i < num_blocks_; ++i)
+        {
+          map_[i] = none__;
+        }
+
+      for (std::size_t e = 0; e < data_blocks_; ++e)
+        {
+          erase_counts_[e] = 0;
+          if (erase ((data_first_ + e) * pages_per_block_, pages_per_block_)
+              < 0)
+            {
+              return -1;
+            }
+        }
+
+      rebuild ();
+
+      // Erase both areas; the snapshot goes to the first one.
+      if (erase (area_page (1, 0), area_pages ()) < 0)
+        {
+          return -1;
+        }
+      journal_area_ = 1;
+      journal_seq_ = 0;
+
+      return checkpoint ();
+    }
+
+    bool
+    block_device_ftl_impl::replay (std::size_t area)
+    {
+      for (std::size_t i = 0; i < num_blocks_; ++i)
+        {
+          map_[i] = none__;
+        }
+      for (std::size_t e = 0; e < data_blocks_; ++e)
+        {
+          erase_counts_[e] = 0;
+        }
+
+      const std::size_t pages = area_pages ();
+      const std::size_t data_pages = data_blocks_ * pages_per_block_;
+
+      bool complete = false;
+      std::uint32_t seq = 0;
+      std::size_t index = 0;
+      for (; index < pages; ++index)
+        {
+          journal_header h;
+          if (!journal_read (area, index, &h))
+            {
+              break;
+            }
+          if ((index > 0) && (h.seq != seq))
+            {
+              break;
+            }
+          if (!complete && ((h.flags & snapshot_flag__) == 0))
+            {
+              // The snapshot was interrupted.
+              break;
+            }
+
+          const std::uint8_t* e = page_buffer_ + sizeof (journal_header);
+          for (std::size_t i = 0; i < h.count; ++i)
+            {
+              std::uint32_t key;
+              std::uint32_t value;
+              std::memcpy (&key, e, sizeof (key));
+              std::memcpy (&value, e + sizeof (key), sizeof (value));
+              e += sizeof (key) + sizeof (value);
+
+              if ((key & erase_count_key__) != 0)
+                {
+                  key &= ~erase_count_key__;
+                  if (key < data_blocks_)
+                    {
+                      erase_counts_[key] = value;
+                    }
+                }
+              else if (key < num_blocks_)
+                {
+                  map_[key] = (value < data_pages) ? value : none__;
+                }
+            }
+
+          if ((h.flags & end_flag__) != 0)
+            {
+              complete = true;
+            }
+          seq = h.seq + 1;
+        }
+
+      if (!complete)
+        {
+          return false;
+        }
+
+      journal_area_ = area;
+      journal_next_ = index;
+      journal_count_ = 0;
+      journal_seq_ = seq;
+
+      return true;
+    }
+
+    /**
+     * @details
+     * Pages are programmed in order, so an erase block without
+     * valid pages is free only if its first page is still erased;
+     * otherwise it may hold pages written but not recorded before
+     * a power failure, and must be erased first.
+     */
+    void
+    block_device_ftl_impl::rebuild (void)
+    {
+      const std::size_t data_pages = data_blocks_ * pages_per_block_;
+      for (std::size_t i = 0; i < data_pages; ++i)
+        {
+          owners_[i] = none__;
+        }
+      for (std::size_t e = 0; e < data_blocks_; ++e)
+        {
+          valid_[e] = 0;
+        }
+
+      for (std::size_t i = 0; i < num_blocks_; ++i)
+        {
+          std::uint32_t page = map_[i];
+          if (page != none__)
+            {
+              owners_[page] = static_cast<std::uint32_t> (i);
+              ++valid_[page / pages_per_block_];
+            }
+        }
+
+      free_count_ = 0;
+      for (std::size_t e = 0; e < data_blocks_; ++e)
+        {
+          if ((valid_[e] == 0)
+              && is_erased (data_page (
+                  static_cast<std::uint32_t> (e * pages_per_block_))))
+            {
+              states_[e] = state::free;
+              ++free_count_;
+            }
+          else
+            {
+              states_[e] = state::used;
+            }
+        }
+
+      current_ = none__;
+      current_next_ = 0;
+    }
+
+    /**
+     * @details
+     * When the free blocks reach the reserve, writes wait for the
+     * collector; the reserve itself is used only by the collector,
+     * to relocate the valid pages of its victims.
+     *
+     * Before a new block is taken for writes, a cold block is
+     * moved if the wear levelling is due, so the levelling keeps
+     * pace with the erases caused by the hot data.
+     */
+    int
+    block_device_ftl_impl::allocate (void)
+    {
+      bool levelled = false;
+      while ((current_ == none__) || (current_next_ == pages_per_block_))
+        {
+          if (current_ != none__)
+            {
+              states_[current_] = state::used;
+              current_ = none__;
+            }
+
+          if (!collecting_)
+            {
+              block_t victim = none__;
+              if (!levelled)
+                {
+                  victim = cold_victim ();
+                  levelled = true;
+                }
+              bool cold = (victim != none__);
+              if (!cold && (free_count_ <= reserve__))
+                {
+                  victim = greedy_victim ();
+                }
+              if (victim != none__)
+                {
+                  if (reclaim (victim, cold) < 0)
+                    {
+                      return -1;
+                    }
+                  // The relocation may have left free pages.
+                  continue;
+                }
+            }
+
+          if (free_count_ <= (collecting_ ? 0 : reserve__))
+            {
+              errno = ENOSPC;
+              return -1;
+            }
+
+          // The least worn free block; cold data moved by the wear
+          // levelling goes to the most worn one instead, which it
+          // will not wear further.
+          block_t best = none__;
+          for (std::size_t e = 0; e < data_blocks_; ++e)
+            {
+              if ((states_[e] == state::free)
+                  && ((best == none__)
+                      || (levelling_
+                              ? (erase_counts_[e] > erase_counts_[best])
+                              : (erase_counts_[e] < erase_counts_[best]))))
+                {
+                  best = e;
+                }
+            }
+          assert (best != none__);
+
+          states_[best] = state::current;
+          --free_count_;
+          current_ = best;
+          current_next_ = 0;
+        }
+
+      return 0;
+    }
+
+    void
+    block_device_ftl_impl::remap (std::uint32_t blknum, std::uint32_t page)
+    {
+      std::uint32_t old = map_[blknum];
+      if (old != none__)
+        {
+          owners_[old] = none__;
+          --valid_[old / pages_per_block_];
+        }
+
+      map_[blknum] = page;
+      if (page != none__)
+        {
+          owners_[page] = blknum;
+          ++valid_[page / pages_per_block_];
+        }
+    }
+
+    /**
+     * @details
+     * In the background, besides the wear levelling, the collector
+     * keeps `spare` blocks free and reclaims the blocks without
+     * valid pages, which only need an erase.
+     */
+    int
+    block_device_ftl_impl::collect (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s() @%p\n", __func__, this);
+#endif
+
+      block_t victim = cold_victim ();
+      bool cold = (victim != none__);
+      if (!cold)
+        {
+          victim = greedy_victim ();
+          if ((victim == none__)
+              || ((valid_[victim] > 0) && (free_count_ >= spare_)))
+            {
+              return 0;
+            }
+        }
+
+      return (reclaim (victim, cold) < 0) ? -1 : 1;
+    }
+
+    block_device_ftl_impl::block_t
+    block_device_ftl_impl::greedy_victim (void) const
+    {
+      block_t victim = none__;
+      for (std::size_t e = 0; e < data_blocks_; ++e)
+        {
+          if ((states_[e] == state::used) && (valid_[e] < pages_per_block_)
+              && ((victim == none__) || (valid_[e] < valid_[victim])))
+            {
+              victim = e;
+            }
+        }
+      return victim;
+    }
+
+    /**
+     * @details
+     * Moving a full block takes at most the reserve, which the
+     * erase of the victim gives back.
+     */
+    block_device_ftl_impl::block_t
+    block_device_ftl_impl::cold_victim (void) const
+    {
+      if (free_count_ < reserve__)
+        {
+          return none__;
+        }
+
+      block_t victim = none__;
+      std::uint32_t most_worn = 0;
+      for (std::size_t e = 0; e < data_blocks_; ++e)
+        {
+          if (erase_counts_[e] > most_worn)
+            {
+              most_worn = erase_counts_[e];
+            }
+          if ((states_[e] == state::used)
+              && ((victim == none__)
+                  || (erase_counts_[e] < erase_counts_[victim])))
+            {
+              victim = e;
+            }
+        }
+
+      if ((victim == none__)
+          || (most_worn - erase_counts_[victim] <= wear_threshold__))
+        {
+          return none__;
+        }
+      return victim;
+    }
+
+    int
+    block_device_ftl_impl::reclaim (block_t block, bool cold)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s(%u, %d) @%p\n", __func__,
+                     block, cold, this);
+#endif
+
+      collecting_ = true;
+      levelling_ = cold;
+
+      int ret = 0;
+      auto first = static_cast<std::uint32_t> (block * pages_per_block_);
+      for (std::uint32_t page = first; page < first + pages_per_block_;
+           ++page)
+        {
+          std::uint32_t lbn = owners_[page];
+          if (lbn == none__)
+            {
+              continue;
+            }
+
+          if ((allocate () < 0)
+              || (parent_.read_block (page_buffer_, data_page (page), 1) != 1))
+            {
+              ret = -1;
+              break;
+            }
+
+          auto to = static_cast<std::uint32_t> (current_ * pages_per_block_
+                                                + current_next_);
+          ++current_next_;
+          if (parent_.write_block (page_buffer_, data_page (to), 1) != 1)
+            {
+              ret = -1;
+              break;
+            }
+
+          remap (lbn, to);
+          journal_record (lbn, to);
+        }
+
+      collecting_ = false;
+      levelling_ = false;
+
+      // The new locations must be recorded before the old ones
+      // are erased.
+      if ((ret < 0) || (journal_flush () < 0))
+        {
+          return -1;
+        }
+
+      return erase_data_block (block);
+    }
+
+    int
+    block_device_ftl_impl::erase_data_block (block_t block)
+    {
+      assert (valid_[block] == 0);
+
+      if (erase ((data_first_ + block) * pages_per_block_, pages_per_block_)
+          < 0)
+        {
+          return -1;
+        }
+
+      ++erase_counts_[block];
+      ++erases_;
+      states_[block] = state::free;
+      ++free_count_;
+
+      // Not urgent; a lost count only makes the block look less worn.
+      return journal_record (
+          static_cast<std::uint32_t> (block) | erase_count_key__,
+          erase_counts_[block]);
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    block_device_ftl_impl::journal_record (std::uint32_t key,
+                                           std::uint32_t value)
+    {
+      if ((journal_count_ == entries_per_page_) && (journal_flush () < 0))
+        {
+          return -1;
+        }
+      return journal_add (key, value, 0);
+    }
+
+    /**
+     * @details
+     * If the area is full, a checkpoint replaces the pending
+     * entries, since the snapshot is taken from the map in RAM.
+     */
+    int
+    block_device_ftl_impl::journal_flush (void)
+    {
+      if (journal_count_ == 0)
+        {
+          return 0;
+        }
+
+      if (journal_next_ >= area_pages ())
+        {
+          return checkpoint ();
+        }
+      return journal_write (0);
+    }
+
+    int
+    block_device_ftl_impl::checkpoint (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+      trace::printf ("block_device_ftl_impl::%s() area %u\n", __func__,
+                     1 - journal_area_);
+#endif
+
+      std::size_t area = 1 - journal_area_;
+      if (erase (area_page (area, 0), area_pages ()) < 0)
+        {
+          return -1;
+        }
+
+      journal_area_ = area;
+      journal_next_ = 0;
+      journal_count_ = 0;
+
+      int ret = 0;
+      for (std::size_t e = 0; (e < data_blocks_) && (ret == 0); ++e)
+        {
+          ret = journal_add (static_cast<std::uint32_t> (e) | erase_count_key__,
+                             erase_counts_[e], snapshot_flag__);
+        }
+      for (std::size_t i = 0; (i < num_blocks_) && (ret == 0); ++i)
+        {
+          if (map_[i] != none__)
+            {
+              ret = journal_add (static_cast<std::uint32_t> (i), map_[i],
+                                 snapshot_flag__);
+            }
+        }
+      if (ret == 0)
+        {
+          ret = journal_write (snapshot_flag__ | end_flag__);
+        }
+
+      if (ret < 0)
+        {
+          // The old area is still the valid one; retry the new one
+          // at the next flush.
+          journal_area_ = 1 - area;
+          journal_next_ = area_pages ();
+        }
+      return ret;
+    }
+
+    int
+    block_device_ftl_impl::journal_add (std::uint32_t key, std::uint32_t value,
+                                        std::uint16_t flags)
+    {
+      if ((journal_count_ == entries_per_page_) && (journal_write (flags) < 0))
+        {
+          return -1;
+        }
+
+      std::uint8_t* e = journal_page_ + sizeof (journal_header)
+                        + journal_count_ * (sizeof (key) + sizeof (value));
+      std::memcpy (e, &key, sizeof (key));
+      std::memcpy (e + sizeof (key), &value, sizeof (value));
+      ++journal_count_;
+
+      return 0;
+    }
+
+    /**
+     * @details
+     * A failed page may be partly programmed and ends the replay,
+     * so the following changes go to a new checkpoint.
+     */
+    int
+    block_device_ftl_impl::journal_write (std::uint16_t flags)
+    {
+      journal_header h;
+      h.magic = journal_magic__;
+      h.seq = journal_seq_;
+      h.flags = flags;
+      h.count = static_cast<std::uint16_t> (journal_count_);
+      h.crc = 0;
+
+      std::size_t size = sizeof (journal_header)
+                         + journal_count_ * 2 * sizeof (std::uint32_t);
+      std::memcpy (journal_page_, &h, sizeof (h));
+      std::memset (journal_page_ + size, 0xFF, page_size_ - size);
+      h.crc = crc32 (0, journal_page_, size);
+      std::memcpy (journal_page_, &h, sizeof (h));
+
+      errno = 0;
+      if (parent_.write_block (journal_page_,
+                               area_page (journal_area_, journal_next_), 1)
+          != 1)
+        {
+          journal_next_ = area_pages ();
+          if (errno == 0)
+            {
+              errno = EIO;
+            }
+          return -1;
+        }
+
+      ++journal_next_;
+      ++journal_seq_;
+      journal_count_ = 0;
+
+      return 0;
+    }
+
+    bool
+    block_device_ftl_impl::journal_read (std::size_t area, std::size_t index,
+                                         journal_header* header)
+    {
+      if (parent_.read_block (page_buffer_, area_page (area, index), 1) != 1)
+        {
+          return false;
+        }
+
+      std::memcpy (header, page_buffer_, sizeof (journal_header));
+      if ((header->magic != journal_magic__)
+          || (header->count > entries_per_page_))
+        {
+          return false;
+        }
+
+      std::uint32_t crc = header->crc;
+      journal_header h = *header;
+      h.crc = 0;
+      std::memcpy (page_buffer_, &h, sizeof (h));
+
+      return crc
+             == crc32 (0, page_buffer_,
+                       sizeof (journal_header)
+                           + header->count * 2 * sizeof (std::uint32_t));
+    }
+
+    /**
+     * @details
+     * A discard is only a hint for most devices, so the first
+     * page of each erase block is read back; pages are programmed
+     * in order, so a block erased only in part is also detected.
+     */
+    int
+    block_device_ftl_impl::erase (blknum_t blknum, std::size_t npages)
+    {
+      if (parent_.discard_blocks (blknum, npages) < 0)
+        {
+          return -1;
+        }
+
+      for (std::size_t i = 0; i < npages; i += pages_per_block_)
+        {
+          if (!is_erased (blknum + i))
+            {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_FTL)
+              trace::printf ("block_device_ftl_impl::%s() %u not erased\n",
+                             __func__, blknum + i);
+#endif
+              errno = EIO;
+              return -1;
+            }
+        }
+      return 0;
+    }
+
+    bool
+    block_device_ftl_impl::is_blank (std::size_t area)
+    {
+      for (std::size_t i = 0; i < area_pages (); ++i)
+        {
+          if (!is_erased (area_page (area, i)))
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+
+    bool
+    block_device_ftl_impl::is_erased (blknum_t blknum)
+    {
+      if (parent_.read_block (page_buffer_, blknum, 1) != 1)
+        {
+          return false;
+        }
+
+      for (std::size_t i = 0; i < page_size_; ++i)
+        {
+          if (page_buffer_[i] != 0xFF)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+
+    // ========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,486 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/block-device-partition-table.h>
+#include <micro-os-plus/posix-io/crc32.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cstring>
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+      // Tables are little endian.
+      inline std::uint32_t
+      le32 (const std::uint8_t* p)
+      {
+        return static_cast<std::uint32_t> (p[0])
+               | (static_cast<std::uint32_t> (p[1]) << 8)
+               | (static_cast<std::uint32_t> (p[2]) << 16)
+               | (static_cast<std::uint32_t> (p[3]) << 24);
+      }
+
+      inline std::uint64_t
+      le64 (const std::uint8_t* p)
+      {
+        return le32 (p) | (static_cast<std::uint64_t> (le32 (p + 4)) << 32);
+      }
+
+      inline bool
+      is_extended (std::uint8_t type)
+      {
+        return (type == 0x05) || (type == 0x0F) || (type == 0x85);
+      }
+
+      constexpr std::size_t mbr_table_offset = 446;
+      constexpr std::size_t mbr_entry_size = 16;
+      // Logical partitions in the extended chain, to stop on loops.
+      constexpr std::size_t mbr_logical_max = 128;
+      constexpr std::uint32_t gpt_entries_max = 1024;
+    } // namespace
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    block_device_partition_table::block_device_partition_table (
+        block_device& parent)
+        : parent_ (parent)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_table::%s(\"%s\")=@%p\n",
+                     __func__, parent.name (), this);
+#endif
+    }
+
+    block_device_partition_table::~block_device_partition_table ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_table::%s() @%p\n", __func__,
+                     this);
+#endif
+
+      clear ();
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    block_device_partition_table::scan (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_table::%s() @%p\n", __func__,
+                     this);
+#endif
+
+      clear ();
+
+      if (parent_.open () < 0)
+        {
+          return -1;
+        }
+
+      int ret;
+      std::size_t size = parent_.block_logical_size_bytes ();
+      if (size < 512)
+        {
+          errno = EINVAL;
+          ret = -1;
+        }
+      else
+        {
+          auto* buf = new std::uint8_t[size];
+          ret = scan_mbr (buf);
+          delete[] buf;
+        }
+
+      int err = errno;
+      parent_.close ();
+      errno = err;
+
+      return (ret < 0) ? ret : static_cast<int> (count_);
+    }
+
+    void
+    block_device_partition_table::clear (void)
+    {
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          delete entries_[i].device;
+          delete[] entries_[i].name;
+        }
+      count_ = 0;
+    }
+
+    /**
+     * @details
+     * A FAT boot sector also ends with the 0x55AA signature, but
+     * boot code in place of the table; such sectors are recognised
+     * by the invalid status bytes, and the device is considered
+     * not partitioned.
+     */
+    int
+    block_device_partition_table::scan_mbr (std::uint8_t* buf)
+    {
+      if (read (buf, 0) < 0)
+        {
+          return -1;
+        }
+
+      if ((buf[510] != 0x55) || (buf[511] != 0xAA))
+        {
+          return 0;
+        }
+
+      std::uint8_t table[4 * mbr_entry_size];
+      std::memcpy (table, buf + mbr_table_offset, sizeof (table));
+
+      for (std::size_t i = 0; i < 4; ++i)
+        {
+          if ((table[i * mbr_entry_size] & 0x7F) != 0)
+            {
+              return 0;
+            }
+        }
+
+      for (std::size_t i = 0; i < 4; ++i)
+        {
+          if (table[i * mbr_entry_size + 4] == 0xEE)
+            {
+              // Protective MBR.
+              return scan_gpt (buf);
+            }
+        }
+
+      blknum_t extended = 0;
+      for (std::size_t i = 0; i < 4; ++i)
+        {
+          const std::uint8_t* e = table + i * mbr_entry_size;
+          std::uint32_t offset = le32 (e + 8);
+          std::uint32_t nblocks = le32 (e + 12);
+          if ((e[4] == 0) || (nblocks == 0))
+            {
+              continue;
+            }
+
+          if (is_extended (e[4]))
+            {
+              if (extended == 0)
+                {
+                  extended = offset;
+                }
+              continue;
+            }
+
+          add (static_cast<unsigned int> (i + 1), offset, nblocks);
+        }
+
+      if (extended != 0)
+        {
+          return scan_extended (buf, extended);
+        }
+      return 0;
+    }
+
+    /**
+     * @details
+     * Each extended boot record describes one logical partition,
+     * relative to itself, and links to the next record, relative
+     * to the start of the extended partition.
+     */
+    int
+    block_device_partition_table::scan_extended (std::uint8_t* buf,
+                                                 blknum_t first)
+    {
+      blknum_t ebr = first;
+      unsigned int number = 5;
+      for (std::size_t i = 0; i < mbr_logical_max; ++i)
+        {
+          if (read (buf, ebr) < 0)
+            {
+              return -1;
+            }
+          if ((buf[510] != 0x55) || (buf[511] != 0xAA))
+            {
+              break;
+            }
+
+          const std::uint8_t* e = buf + mbr_table_offset;
+          if ((e[4] != 0) && (le32 (e + 12) != 0))
+            {
+              add (number, ebr + le32 (e + 8), le32 (e + 12));
+            }
+          ++number;
+
+          e += mbr_entry_size;
+          if (!is_extended (e[4]) || (le32 (e + 8) == 0))
+            {
+              break;
+            }
+          ebr = first + le32 (e + 8);
+        }
+      return 0;
+    }
+
+    int
+    block_device_partition_table::scan_gpt (std::uint8_t* buf)
+    {
+      candidate candidates[entries_max__];
+      std::size_t count;
+
+      if (read_gpt (buf, 1, candidates, &count) < 0)
+        {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+          trace::printf ("block_device_partition_table::%s() backup\n",
+                         __func__);
+#endif
+          if (read_gpt (buf, parent_.blocks () - 1, candidates, &count) < 0)
+            {
+              return -1;
+            }
+        }
+
+      for (std::size_t i = 0; i < count; ++i)
+        {
+          add (candidates[i].number, candidates[i].offset,
+               candidates[i].nblocks);
+        }
+      return 0;
+    }
+
+    /**
+     * @details
+     * The entries are collected while their CRC is computed, and
+     * used only if it matches.
+     */
+    int
+    block_device_partition_table::read_gpt (std::uint8_t* buf, blknum_t lba,
+                                            candidate* candidates,
+                                            std::size_t* count)
+    {
+      *count = 0;
+
+      if (read (buf, lba) < 0)
+        {
+          return -1;
+        }
+
+      const std::size_t size = parent_.block_logical_size_bytes ();
+      const std::uint64_t blocks = parent_.blocks ();
+
+      std::uint32_t header_size = le32 (buf + 12);
+      if ((std::memcmp (buf, "EFI PART", 8) != 0) || (header_size < 92)
+          || (header_size > size))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      std::uint32_t header_crc = le32 (buf + 16);
+      std::memset (buf + 16, 0, 4);
+      if ((crc32 (0, buf, header_size) != header_crc)
+          || (le64 (buf + 24) != lba))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      std::uint64_t first_usable = le64 (buf + 40);
+      std::uint64_t last_usable = le64 (buf + 48);
+      std::uint64_t entries_lba = le64 (buf + 72);
+      std::uint32_t entries = le32 (buf + 80);
+      std::uint32_t entry_size = le32 (buf + 84);
+      std::uint32_t entries_crc = le32 (buf + 88);
+
+      if ((entry_size < 128) || ((entry_size % 8) != 0)
+          || ((size % entry_size) != 0) || (entries > gpt_entries_max))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      std::size_t bytes = static_cast<std::size_t> (entries) * entry_size;
+      std::size_t nblocks = (bytes + size - 1) / size;
+      if (entries_lba + nblocks > blocks)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      std::uint32_t crc = 0;
+      unsigned int number = 1;
+      for (std::size_t b = 0; b < nblocks; ++b)
+        {
+          if (read (buf, static_cast<blknum_t> (entries_lba + b)) < 0)
+            {
+              return -1;
+            }
+
+          std::size_t chunk = bytes - b * size;
+          if (chunk > size)
+            {
+              chunk = size;
+            }
+          crc = crc32 (crc, buf, chunk);
+
+          for (std::size_t offset = 0; offset < chunk;
+               offset += entry_size, ++number)
+            {
+              const std::uint8_t* e = buf + offset;
+              bool used = false;
+              for (std::size_t k = 0; k < 16; ++k)
+                {
+                  used = used || (e[k] != 0);
+                }
+
+              std::uint64_t first = le64 (e + 32);
+              std::uint64_t last = le64 (e + 40);
+              if (!used || (last < first) || (first < first_usable)
+                  || (last > last_usable) || (last >= blocks))
+                {
+                  continue;
+                }
+
+              if (*count < entries_max__)
+                {
+                  candidates[*count].number = number;
+                  candidates[*count].offset = static_cast<blknum_t> (first);
+                  candidates[*count].nblocks
+                      = static_cast<blknum_t> (last - first + 1);
+                  ++*count;
+                }
+            }
+        }
+
+      if (crc != entries_crc)
+        {
+          *count = 0;
+          errno = EINVAL;
+          return -1;
+        }
+      return 0;
+    }
+
+    void
+    block_device_partition_table::add (unsigned int number, blknum_t offset,
+                                       blknum_t nblocks)
+    {
+      blknum_t blocks = parent_.blocks ();
+      if ((count_ == entries_max__) || (offset >= blocks)
+          || (nblocks > blocks - offset))
+        {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+          trace::printf ("block_device_partition_table::%s() skip %u\n",
+                         __func__, number);
+#endif
+          return;
+        }
+
+      // The parent name followed by the number.
+      const char* parent_name = parent_.name ();
+      std::size_t length = std::strlen (parent_name);
+      char digits[10];
+      std::size_t ndigits = 0;
+      unsigned int n = number;
+      do
+        {
+          digits[ndigits++] = static_cast<char> ('0' + n % 10);
+          n /= 10;
+        }
+      while (n != 0);
+
+      char* name = new char[length + ndigits + 1];
+      std::memcpy (name, parent_name, length);
+      for (std::size_t i = 0; i < ndigits; ++i)
+        {
+          name[length + i] = digits[ndigits - 1 - i];
+        }
+      name[length + ndigits] = '\0';
+
+      std::size_t physical = parent_.block_physical_size_bytes ();
+
+      entry& e = entries_[count_];
+      e.name = name;
+      e.number = number;
+      e.aligned = (physical == 0)
+                  || (((offset * parent_.block_logical_size_bytes ())
+                       % physical)
+                      == 0);
+      e.device = new block_device_partition_implementable<> (name, parent_);
+      e.device->configure (offset, nblocks);
+      ++count_;
+
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_table::%s() %s %u+%u%s\n",
+                     __func__, name, offset, nblocks,
+                     e.aligned ? "" : " not aligned");
+#endif
+    }
+
+    int
+    block_device_partition_table::read (std::uint8_t* buf, blknum_t blknum)
+    {
+      errno = 0;
+      if (parent_.read_block (buf, blknum, 1) != 1)
+        {
+          if (errno == 0)
+            {
+              errno = EIO;
+            }
+          return -1;
+        }
+      return 0;
+    }
+
+    // ========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
@@ -135,7 +135,31 @@ namespace micro_os_plus
                      oflag, this);
 #endif
 
-      return parent_.vopen (path, oflag, arguments);
+      int ret = parent_.vopen (path, oflag, arguments);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      // Validate the partition once against the parent, so that the
+      // requests, already checked against the partition range, can
+      // be passed directly to the parent implementation.
+      if ((partition_offset_blocks_ > parent_.blocks ())
+          || (num_blocks_ > parent_.blocks () - partition_offset_blocks_))
+        {
+          parent_.close ();
+          errno = EINVAL;
+          return -1;
+        }
+
+      // Lockable (and queued) parents serialise the requests in
+      // their wrapper, which may be bypassed only if this partition
+      // is serialised by the same lock.
+      const void* domain = parent_.lock_domain ();
+      is_direct_ = !parent_.is_lockable ()
+                   || ((domain != nullptr) && (domain == lock_domain_));
+
+      return ret;
     }
 
     ssize_t
@@ -147,8 +171,14 @@ namespace micro_os_plus
                      __func__, buf, blknum, nblocks, this);
 #endif
 
-      return parent_.read_block (buf, blknum + partition_offset_blocks_,
-                                 nblocks);
+      if (!is_direct_)
+        {
+          return parent_.read_block (buf, blknum + partition_offset_blocks_,
+                                     nblocks);
+        }
+
+      return parent_.impl ().do_read_block (
+          buf, blknum + partition_offset_blocks_, nblocks);
     }
 
     ssize_t
@@ -161,8 +191,112 @@ namespace micro_os_plus
                      __func__, buf, blknum, nblocks, this);
 #endif
 
-      return parent_.write_block (buf, blknum + partition_offset_blocks_,
-                                  nblocks);
+      if (!is_direct_)
+        {
+          return parent_.write_block (buf, blknum + partition_offset_blocks_,
+                                      nblocks);
+        }
+
+      block_device_impl& parent_impl = parent_.impl ();
+      parent_impl.read_ahead_invalidate (blknum + partition_offset_blocks_,
+                                         nblocks);
+
+      return parent_impl.do_write_block (
+          buf, blknum + partition_offset_blocks_, nblocks);
+    }
+
+    /**
+     * @details
+     * The request is passed down with the offset added to the
+     * block number; `block_request::complete()` removes it, so
+     * the caller never sees the parent block number.
+     */
+    int
+    block_device_partition_impl::do_submit_block (block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_impl::%s(%p) @%p\n", __func__,
+                     &request, this);
+#endif
+
+      request.blknum_ += partition_offset_blocks_;
+      request.offset_ += partition_offset_blocks_;
+
+      int ret;
+      if (!is_direct_)
+        {
+          ret = parent_.submit_block (request);
+        }
+      else
+        {
+          block_device_impl& parent_impl = parent_.impl ();
+          if (request.op_ == block_request::opcode::write)
+            {
+              parent_impl.read_ahead_invalidate (request.blknum_,
+                                                 request.nblocks_);
+            }
+          ret = parent_impl.do_submit_block (request);
+        }
+
+      if (ret < 0)
+        {
+          // Not accepted, thus not completed.
+          request.blknum_ -= partition_offset_blocks_;
+          request.offset_ -= partition_offset_blocks_;
+        }
+      return ret;
+    }
+
+    int
+    block_device_partition_impl::do_discard (blknum_t blknum,
+                                             std::size_t nblocks, bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_impl::%s(%u, %u, %d) @%p\n",
+                     __func__, blknum, nblocks, secure, this);
+#endif
+
+      if (!is_direct_)
+        {
+          return parent_.discard_blocks (blknum + partition_offset_blocks_,
+                                         nblocks, secure);
+        }
+
+      block_device_impl& parent_impl = parent_.impl ();
+      parent_impl.read_ahead_invalidate (blknum + partition_offset_blocks_,
+                                         nblocks);
+
+      return parent_impl.do_discard (blknum + partition_offset_blocks_,
+                                     nblocks, secure);
+    }
+
+    int
+    block_device_partition_impl::do_write_zeroes (blknum_t blknum,
+                                                  std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_PARTITION)
+      trace::printf ("block_device_partition_impl::%s(%u, %u) @%p\n",
+                     __func__, blknum, nblocks, this);
+#endif
+
+      if (!is_direct_)
+        {
+          return parent_.write_zeroes (blknum + partition_offset_blocks_,
+                                       nblocks);
+        }
+
+      block_device_impl& parent_impl = parent_.impl ();
+      parent_impl.read_ahead_invalidate (blknum + partition_offset_blocks_,
+                                         nblocks);
+
+      return parent_impl.do_write_zeroes (blknum + partition_offset_blocks_,
+                                          nblocks);
+    }
+
+    block_device::blknum_t
+    block_device_partition_impl::do_base_block (void)
+    {
+      return partition_offset_blocks_ + parent_.impl ().do_base_block ();
     }
 
     void
@@ -173,7 +307,13 @@ namespace micro_os_plus
                      this);
 #endif
 
-      return parent_.sync ();
+      if (!is_direct_)
+        {
+          parent_.sync ();
+          return;
+        }
+
+      parent_.impl ().do_sync ();
     }
 
     int
@@ -187,6 +327,20 @@ namespace micro_os_plus
       return parent_.close ();
     }
 
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wweak-template-vtables"
+#pragma clang diagnostic ignored "-Wc++98-compat-pedantic"
+#endif
+
+    // Matches the `extern template` in the header.
+    template class block_device_partition_implementable<
+        block_device_partition_impl>;
+
+#pragma GCC diagnostic pop
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus
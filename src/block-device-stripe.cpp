@@ -0,0 +1,460 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2018 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <micro-os-plus/posix-io/block-device-stripe.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    block_device_stripe_impl::block_device_stripe_impl (
+        block_device* const* members, std::size_t count,
+        std::size_t chunk_blocks)
+        : count_ (count), //
+          chunk_blocks_ (chunk_blocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s(%u, %u)=@%p\n", __func__,
+                     count, chunk_blocks, this);
+#endif
+
+      assert (count > 0 && count <= members_max__);
+      assert (chunk_blocks > 0);
+
+      for (std::size_t i = 0; i < count; ++i)
+        {
+          members_[i] = members[i];
+        }
+    }
+
+    block_device_stripe_impl::~block_device_stripe_impl ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s() @%p\n", __func__, this);
+#endif
+    }
+
+    // ------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    int
+    block_device_stripe_impl::do_vioctl (int request, std::va_list arguments)
+    {
+      errno = ENOSYS;
+      return -1;
+    }
+
+#pragma GCC diagnostic pop
+
+    /**
+     * @details
+     * All members must have the same logical block size; the
+     * capacity is rounded down to a multiple of the stripe size,
+     * so each member contributes the same number of chunks.
+     */
+    int
+    block_device_stripe_impl::do_vopen (const char* path, int oflag,
+                                        std::va_list arguments)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s(%d) @%p\n", __func__,
+                     oflag, this);
+#endif
+
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          std::va_list args;
+          va_copy (args, arguments);
+          int ret = members_[i]->vopen (path, oflag, args);
+          va_end (args);
+
+          if (ret < 0)
+            {
+              int error = errno;
+              close_members (i);
+              errno = error;
+              return -1;
+            }
+        }
+
+      std::size_t size = members_[0]->block_logical_size_bytes ();
+      std::size_t physical = 0;
+      blknum_t nblocks = members_[0]->blocks ();
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          if (members_[i]->block_logical_size_bytes () != size)
+            {
+              size = 0;
+              break;
+            }
+          if (members_[i]->block_physical_size_bytes () > physical)
+            {
+              physical = members_[i]->block_physical_size_bytes ();
+            }
+          if (members_[i]->blocks () < nblocks)
+            {
+              nblocks = members_[i]->blocks ();
+            }
+        }
+
+      blknum_t rows = nblocks / chunk_blocks_;
+      if ((size == 0) || (rows == 0))
+        {
+          close_members (count_);
+          errno = EINVAL;
+          return -1;
+        }
+
+      block_logical_size_bytes_ = size;
+      block_physical_size_bytes_ = physical;
+      num_blocks_ = rows * chunk_blocks_ * count_;
+
+      return 0;
+    }
+
+    ssize_t
+    block_device_stripe_impl::do_read_block (void* buf, blknum_t blknum,
+                                             std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s(0x%X, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      return transfer (block_request::opcode::read, buf, blknum, nblocks);
+    }
+
+    ssize_t
+    block_device_stripe_impl::do_write_block (const void* buf,
+                                              blknum_t blknum,
+                                              std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s(0x%X, %u, %u) @%p\n",
+                     __func__, buf, blknum, nblocks, this);
+#endif
+
+      // The requests are shared by reads and writes; writes never
+      // modify the buffer.
+      return transfer (block_request::opcode::write, const_cast<void*> (buf),
+                       blknum, nblocks);
+    }
+
+    /**
+     * @details
+     * The blocks of a range which belong to one member are
+     * contiguous on that member, so each member gets a single
+     * request.
+     */
+    int
+    block_device_stripe_impl::do_discard (blknum_t blknum,
+                                          std::size_t nblocks, bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s(%u, %u, %d) @%p\n",
+                     __func__, blknum, nblocks, secure, this);
+#endif
+
+      int ret = 0;
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          blknum_t first;
+          blknum_t last;
+          if (member_range (i, blknum, nblocks, &first, &last))
+            {
+              if (members_[i]->discard_blocks (first, last - first, secure)
+                  < 0)
+                {
+                  ret = -1;
+                }
+            }
+        }
+
+      return ret;
+    }
+
+    int
+    block_device_stripe_impl::do_write_zeroes (blknum_t blknum,
+                                               std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s(%u, %u) @%p\n", __func__,
+                     blknum, nblocks, this);
+#endif
+
+      int ret = 0;
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          blknum_t first;
+          blknum_t last;
+          if (member_range (i, blknum, nblocks, &first, &last))
+            {
+              if (members_[i]->write_zeroes (first, last - first) < 0)
+                {
+                  ret = -1;
+                }
+            }
+        }
+
+      return ret;
+    }
+
+    void
+    block_device_stripe_impl::do_sync (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s() @%p\n", __func__, this);
+#endif
+
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          members_[i]->sync ();
+        }
+    }
+
+    int
+    block_device_stripe_impl::do_close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE_STRIPE)
+      trace::printf ("block_device_stripe_impl::%s() @%p\n", __func__, this);
+#endif
+
+      return close_members (count_);
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * The chunks go round robin to the members; a member still
+     * busy with the previous chunk is waited for before being
+     * given the next one, while the others continue, so up to
+     * one request per member is in flight. There is no other
+     * concurrency: a member with a synchronous driver completes
+     * the request inside `submit_block()`, before the next member
+     * is given one.
+     *
+     * Like the drivers, the transfer is all or nothing; after a
+     * failure no more chunks are submitted, the requests in
+     * flight are waited for, and the first error is returned.
+     */
+    ssize_t
+    block_device_stripe_impl::transfer (block_request::opcode op, void* buf,
+                                        blknum_t blknum, std::size_t nblocks)
+    {
+      auto* p = static_cast<std::uint8_t*> (buf);
+      std::size_t remaining = nblocks;
+
+      unsigned int busy = 0; // One bit for each member.
+      int error = 0;
+      while (remaining > 0)
+        {
+          blknum_t chunk = blknum / chunk_blocks_;
+          std::size_t skip = blknum % chunk_blocks_;
+          std::size_t n = chunk_blocks_ - skip;
+          if (n > remaining)
+            {
+              n = remaining;
+            }
+
+          std::size_t member = chunk % count_;
+          if ((busy & (1u << member)) != 0)
+            {
+              busy &= ~(1u << member);
+              error = wait (member);
+              if (error != 0)
+                {
+                  break;
+                }
+            }
+
+          block_request& request = requests_[member];
+          request.op_ = op;
+          request.buf_ = p;
+          request.blknum_ = (chunk / count_) * chunk_blocks_ + skip;
+          request.nblocks_ = n;
+          request.callback_ = completed;
+          request.user_data_ = this;
+
+          errno = 0;
+          if (members_[member]->submit_block (request) < 0)
+            {
+              error = (errno != 0) ? errno : EIO;
+              break;
+            }
+          busy |= (1u << member);
+
+          p += n * block_logical_size_bytes_;
+          blknum += n;
+          remaining -= n;
+        }
+
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          if ((busy & (1u << i)) != 0)
+            {
+              int ret = wait (i);
+              if (error == 0)
+                {
+                  error = ret;
+                }
+            }
+        }
+
+      if (error != 0)
+        {
+          errno = error;
+          return -1;
+        }
+
+      return static_cast<ssize_t> (nblocks);
+    }
+
+    /**
+     * @details
+     * The waiter is armed before checking the request, so a
+     * completion which occurs in between makes `wait()` return
+     * immediately instead of being lost.
+     */
+    int
+    block_device_stripe_impl::wait (std::size_t member)
+    {
+      block_request& request = requests_[member];
+      while (true)
+        {
+          waiter_.arm ();
+          if (request.done ())
+            {
+              break;
+            }
+          waiter_.wait (nullptr);
+        }
+
+      if (request.result () < 0)
+        {
+          return (request.error () != 0) ? request.error () : EIO;
+        }
+      if (static_cast<std::size_t> (request.result ()) != request.nblocks_)
+        {
+          return EIO;
+        }
+
+      return 0;
+    }
+
+    bool
+    block_device_stripe_impl::member_range (std::size_t member,
+                                            blknum_t blknum,
+                                            std::size_t nblocks,
+                                            blknum_t* first,
+                                            blknum_t* last) const
+    {
+      if (nblocks == 0)
+        {
+          return false;
+        }
+
+      // The first chunk of the member at or after the start.
+      blknum_t chunk = blknum / chunk_blocks_;
+      std::size_t ahead = (member + count_ - chunk % count_) % count_;
+      if ((chunk + ahead) * chunk_blocks_ >= blknum + nblocks)
+        {
+          return false;
+        }
+      if (ahead == 0)
+        {
+          *first = (chunk / count_) * chunk_blocks_ + blknum % chunk_blocks_;
+        }
+      else
+        {
+          *first = ((chunk + ahead) / count_) * chunk_blocks_;
+        }
+
+      // The last chunk of the member before the end; since the
+      // first one exists, it is not before it.
+      blknum_t end = blknum + nblocks - 1;
+      chunk = end / chunk_blocks_;
+      std::size_t behind = (chunk % count_ + count_ - member) % count_;
+      if (behind == 0)
+        {
+          *last = (chunk / count_) * chunk_blocks_ + end % chunk_blocks_ + 1;
+        }
+      else
+        {
+          *last = ((chunk - behind) / count_ + 1) * chunk_blocks_;
+        }
+
+      return true;
+    }
+
+    int
+    block_device_stripe_impl::close_members (std::size_t count)
+    {
+      int ret = 0;
+      for (std::size_t i = 0; i < count; ++i)
+        {
+          if (members_[i]->close () < 0)
+            {
+              ret = -1;
+            }
+        }
+
+      return ret;
+    }
+
+    void
+    block_device_stripe_impl::completed (block_request& request)
+    {
+      static_cast<block_device_stripe_impl*> (request.user_data_)
+          ->waiter_.wakeup ();
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
@@ -27,13 +27,17 @@
 
 #include <micro-os-plus/posix-io/block-device.h>
 #include <micro-os-plus/posix-io/device-registry.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
 
 #include <micro-os-plus/posix/sys/ioctl.h>
+#include <micro-os-plus/posix/sys/uio.h>
 
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 #include <cerrno>
 #include <cstdarg>
+#include <limits>
 
 // ----------------------------------------------------------------------------
 
@@ -47,6 +51,25 @@ namespace micro_os_plus
 {
   namespace posix
   {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS > 0
+
+    // Allocated in the BSS.
+    std::uint8_t block_device_impl::bounce_buffer::pool__[pool_buffers__]
+                                                         [pool_buffer_size__];
+    unsigned int block_device_impl::bounce_buffer::pool_used__;
+
+#endif
+
+    /**
+     * @endcond
+     */
+
     // ========================================================================
 
     block_device::block_device (block_device_impl& impl, const char* name)
@@ -72,6 +95,25 @@ namespace micro_os_plus
 
     // ------------------------------------------------------------------------
 
+    int
+    block_device::close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device::%s() @%p\n", __func__, this);
+#endif
+
+      int ret = device::close ();
+
+      if (!impl ().do_is_opened ())
+        {
+          // The media, and the block size, may be changed while closed.
+          impl ().read_ahead_resize (impl ().read_ahead_blocks_);
+          impl ().sequential_next_ = 0;
+        }
+
+      return ret;
+    }
+
     ssize_t
     block_device::read_block (void* buf, blknum_t blknum, std::size_t nblocks)
     {
@@ -80,7 +122,8 @@ namespace micro_os_plus
                      blknum, nblocks, this);
 #endif
 
-      if (blknum + nblocks > impl ().num_blocks_)
+      if ((blknum > impl ().num_blocks_)
+          || (nblocks > impl ().num_blocks_ - blknum))
         {
           errno = EINVAL;
           return -1;
@@ -104,7 +147,8 @@ namespace micro_os_plus
                      blknum, nblocks, this);
 #endif
 
-      if (blknum + nblocks > impl ().num_blocks_)
+      if ((blknum > impl ().num_blocks_)
+          || (nblocks > impl ().num_blocks_ - blknum))
         {
           errno = EINVAL;
           return -1;
@@ -116,9 +160,106 @@ namespace micro_os_plus
           return -1;
         }
 
+      impl ().read_ahead_invalidate (blknum, nblocks);
+
       return impl ().do_write_block (buf, blknum, nblocks);
     }
 
+    int
+    block_device::submit_block (block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device::%s(%p) @%p\n", __func__, &request, this);
+#endif
+
+      if ((request.blknum_ > impl ().num_blocks_)
+          || (request.nblocks_ > impl ().num_blocks_ - request.blknum_))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      request.done_.store (false, std::memory_order_relaxed);
+      request.result_ = 0;
+      request.error_ = 0;
+
+      if (request.op_ == block_request::opcode::write)
+        {
+          impl ().read_ahead_invalidate (request.blknum_, request.nblocks_);
+        }
+
+      return impl ().do_submit_block (request);
+    }
+
+    int
+    block_device::discard_blocks (blknum_t blknum, std::size_t nblocks,
+                                  bool secure)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device::%s(%u, %u, %d) @%p\n", __func__, blknum,
+                     nblocks, secure, this);
+#endif
+
+      if ((blknum > impl ().num_blocks_)
+          || (nblocks > impl ().num_blocks_ - blknum))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      if (nblocks == 0)
+        {
+          return 0;
+        }
+
+      impl ().read_ahead_invalidate (blknum, nblocks);
+
+      return impl ().do_discard (blknum, nblocks, secure);
+    }
+
+    int
+    block_device::write_zeroes (blknum_t blknum, std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device::%s(%u, %u) @%p\n", __func__, blknum,
+                     nblocks, this);
+#endif
+
+      if ((blknum > impl ().num_blocks_)
+          || (nblocks > impl ().num_blocks_ - blknum))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      if (nblocks == 0)
+        {
+          return 0;
+        }
+
+      impl ().read_ahead_invalidate (blknum, nblocks);
+
+      return impl ().do_write_zeroes (blknum, nblocks);
+    }
+
     int
     block_device::vioctl (int request, std::va_list arguments)
     {
@@ -185,6 +326,84 @@ namespace micro_os_plus
             return 0;
           }
 
+        case BLKRASET:
+          // Set the read-ahead window, in blocks; 0 disables it.
+          {
+            std::size_t nblocks = va_arg (arguments, std::size_t);
+            impl ().read_ahead_resize (nblocks);
+            return 0;
+          }
+
+        case BLKRAGET:
+          // Get the read-ahead window, in blocks.
+          {
+            std::size_t* nblocks = va_arg (arguments, std::size_t*);
+            if (nblocks == nullptr)
+              {
+                errno = EINVAL;
+                return -1;
+              }
+
+            *nblocks = impl ().read_ahead_blocks_;
+            return 0;
+          }
+
+        case BLKDISCARD:
+        case BLKSECDISCARD:
+        case BLKZEROOUT:
+          // The argument is a pair of 64-bit byte offset and length;
+          // discards must be aligned to the physical (erase) blocks,
+          // zeroes to the logical blocks.
+          {
+            uint64_t* range = va_arg (arguments, uint64_t*);
+            std::size_t logical = impl ().block_logical_size_bytes_;
+            if ((range == nullptr) || (logical == 0))
+              {
+                errno = EINVAL;
+                return -1;
+              }
+
+            // Check the range in bytes, before narrowing it to blocks.
+            uint64_t size
+                = static_cast<uint64_t> (impl ().num_blocks_) * logical;
+            if ((range[0] > size) || (range[1] > size - range[0]))
+              {
+                errno = EINVAL;
+                return -1;
+              }
+
+            std::size_t align = logical;
+            if ((static_cast<unsigned int> (request) != BLKZEROOUT)
+                && (impl ().block_physical_size_bytes_ > align))
+              {
+                align = impl ().block_physical_size_bytes_;
+              }
+
+            // Partitions pass the requests to the parent, so the
+            // alignment is checked on the underlying device.
+            uint64_t base
+                = static_cast<uint64_t> (impl ().do_base_block ()) * logical;
+            if ((((base + range[0]) % align) != 0)
+                || ((range[1] % align) != 0))
+              {
+                errno = EINVAL;
+                return -1;
+              }
+
+            auto blknum = static_cast<blknum_t> (range[0] / logical);
+            auto nblocks = static_cast<std::size_t> (range[1] / logical);
+
+            // Not the virtual functions, the lockable classes
+            // already hold the lock here.
+            if (static_cast<unsigned int> (request) == BLKZEROOUT)
+              {
+                return block_device::write_zeroes (blknum, nblocks);
+              }
+            return block_device::discard_blocks (
+                blknum, nblocks,
+                (static_cast<unsigned int> (request) == BLKSECDISCARD));
+          }
+
         default:
 
           // Execute the implementation specific code.
@@ -192,6 +411,43 @@ namespace micro_os_plus
         }
     }
 
+    bool
+    block_device::is_lockable (void) const
+    {
+      return false;
+    }
+
+    const void*
+    block_device::lock_domain (void) const
+    {
+      return nullptr;
+    }
+
+    // ========================================================================
+
+    /**
+     * @details
+     * The block number, shifted by the partitions on the way down,
+     * is restored first. The result is stored before `done()`
+     * becomes true, so a caller polling it needs no lock; the
+     * callback is invoked last, and may reuse the request.
+     */
+    void
+    block_request::complete (ssize_t result, int error)
+    {
+      blknum_ -= offset_;
+      offset_ = 0;
+
+      result_ = result;
+      error_ = error;
+      done_.store (true, std::memory_order_release);
+
+      if (callback_ != nullptr)
+        {
+          callback_ (*this);
+        }
+    }
+
     // ========================================================================
 
     block_device_impl::block_device_impl (void)
@@ -207,12 +463,86 @@ namespace micro_os_plus
       trace::printf ("block_device_impl::%s() @%p\n", __func__, this);
 #endif
 
+      delete[] read_ahead_buffer_;
+
       block_logical_size_bytes_ = 0;
       num_blocks_ = 0;
     }
 
     // ------------------------------------------------------------------------
 
+    int
+    block_device_impl::do_submit_block (block_request& request)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_impl::%s(%p) @%p\n", __func__, &request,
+                     this);
+#endif
+
+      errno = 0;
+      ssize_t ret;
+      if (request.op_ == block_request::opcode::write)
+        {
+          ret = do_write_block (request.buf_, request.blknum_,
+                                request.nblocks_);
+        }
+      else
+        {
+          ret = do_read_block (request.buf_, request.blknum_,
+                               request.nblocks_);
+        }
+
+      request.complete (ret, (ret < 0) ? errno : 0);
+      return 0;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    int
+    block_device_impl::do_discard (blknum_t blknum, std::size_t nblocks,
+                                   bool secure)
+    {
+      errno = ENOTSUP;
+      return -1;
+    }
+
+#pragma GCC diagnostic pop
+
+    int
+    block_device_impl::do_write_zeroes (blknum_t blknum, std::size_t nblocks)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_impl::%s(%u, %u) @%p\n", __func__, blknum,
+                     nblocks, this);
+#endif
+
+      bounce_buffer zeroes{ block_logical_size_bytes_ };
+      std::memset (zeroes.data (), 0, block_logical_size_bytes_);
+
+      for (std::size_t i = 0; i < nblocks; ++i)
+        {
+          errno = 0;
+          if (do_write_block (zeroes.data (), blknum + i, 1) != 1)
+            {
+              if (errno == 0)
+                {
+                  errno = EIO;
+                }
+              return -1;
+            }
+        }
+      return 0;
+    }
+
+    block_device::blknum_t
+    block_device_impl::do_base_block (void)
+    {
+      return 0;
+    }
+
+    // ------------------------------------------------------------------------
+
     off_t
     block_device_impl::do_lseek (off_t offset, int whence)
     {
@@ -258,66 +588,632 @@ namespace micro_os_plus
                      nbyte, this);
 #endif
 
-      if ((block_logical_size_bytes_ == 0)
-          || ((nbyte % block_logical_size_bytes_) != 0)
-          || ((static_cast<std::size_t> (offset_) % block_logical_size_bytes_)
-              != 0))
+      // The offset is updated by the caller.
+      return do_pread (buf, nbyte, offset_);
+    }
+
+    ssize_t
+    block_device_impl::do_write (const void* buf, std::size_t nbyte)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_impl::%s(%p, %u) @%p\n", __func__, buf,
+                     nbyte, this);
+#endif
+
+      // The offset is updated by the caller.
+      return do_pwrite (buf, nbyte, offset_);
+    }
+
+    /**
+     * @details
+     * Buffers adjacent in memory are merged into runs. Runs of at
+     * least `MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_GATHER_BLOCKS`
+     * blocks are transferred directly into the caller buffers;
+     * shorter ones are read together into a bounce buffer with a
+     * single multi-block transfer, and then scattered, so the
+     * driver setup and bus transaction cost is paid once per batch,
+     * not per iovec.
+     *
+     * As for `read()`, the offset need not be block aligned.
+     */
+    ssize_t
+    block_device_impl::do_readv (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_impl::%s(%p, %d) @%p\n", __func__, iov,
+                     iovcnt, this);
+#endif
+
+      ssize_t total = validate_iovecs (iov, iovcnt);
+      if (total < 0)
+        {
+          return -1;
+        }
+
+      std::size_t nbyte;
+      if (contiguous_iovecs (iov, iovcnt, &nbyte) == iovcnt)
+        {
+          return do_pread (iov->iov_base, nbyte, offset_);
+        }
+
+      const std::size_t gather_size
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_GATHER_BLOCKS
+            * block_logical_size_bytes_;
+      bounce_buffer bounce{ std::min (static_cast<std::size_t> (total),
+                                      gather_size) };
+
+      off_t offset = offset_;
+      std::size_t done = 0;
+      while (iovcnt > 0)
+        {
+          int cnt = contiguous_iovecs (iov, iovcnt, &nbyte);
+          if (nbyte >= gather_size)
+            {
+              ssize_t ret = do_pread (iov->iov_base, nbyte, offset);
+              if (ret < 0)
+                {
+                  return (done > 0) ? static_cast<ssize_t> (done) : ret;
+                }
+              done += static_cast<std::size_t> (ret);
+              offset += ret;
+              if (static_cast<std::size_t> (ret) < nbyte)
+                {
+                  break;
+                }
+
+              iov += cnt;
+              iovcnt -= cnt;
+              continue;
+            }
+
+          // Batch the following short runs.
+          std::size_t len = 0;
+          cnt = 0;
+          while (cnt < iovcnt)
+            {
+              int n = contiguous_iovecs (iov + cnt, iovcnt - cnt, &nbyte);
+              if (len + nbyte > gather_size)
+                {
+                  break;
+                }
+              len += nbyte;
+              cnt += n;
+            }
+
+          ssize_t ret = do_pread (bounce.data (), len, offset);
+          if (ret < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+
+          // Scatter only what was actually read.
+          const std::uint8_t* q = bounce.data ();
+          std::size_t rest = static_cast<std::size_t> (ret);
+          for (int i = 0; i < cnt && rest > 0; ++i)
+            {
+              std::size_t n = std::min (iov[i].iov_len, rest);
+              std::memcpy (iov[i].iov_base, q, n);
+              q += n;
+              rest -= n;
+            }
+          done += static_cast<std::size_t> (ret);
+          offset += ret;
+          if (static_cast<std::size_t> (ret) < len)
+            {
+              break;
+            }
+
+          iov += cnt;
+          iovcnt -= cnt;
+        }
+
+      // The offset is updated by the caller.
+      return static_cast<ssize_t> (done);
+    }
+
+    /**
+     * @details
+     * The reverse of `do_readv()`: short runs are gathered into a
+     * bounce buffer and written with a single multi-block transfer.
+     * A batch that does not end on a block boundary is completed
+     * with a read-modify-write of its last block, as for `write()`.
+     */
+    ssize_t
+    block_device_impl::do_writev (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_impl::%s(%p, %d) @%p\n", __func__, iov,
+                     iovcnt, this);
+#endif
+
+      ssize_t total = validate_iovecs (iov, iovcnt);
+      if (total < 0)
         {
-          errno = EINVAL;
           return -1;
         }
 
-      std::size_t nblocks = nbyte / block_logical_size_bytes_;
-      blknum_t blknum
-          = static_cast<std::size_t> (offset_) / block_logical_size_bytes_;
+      std::size_t nbyte;
+      if (contiguous_iovecs (iov, iovcnt, &nbyte) == iovcnt)
+        {
+          return do_pwrite (iov->iov_base, nbyte, offset_);
+        }
+
+      const std::size_t gather_size
+          = MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_GATHER_BLOCKS
+            * block_logical_size_bytes_;
+      bounce_buffer bounce{ std::min (static_cast<std::size_t> (total),
+                                      gather_size) };
+
+      off_t offset = offset_;
+      std::size_t done = 0;
+      while (iovcnt > 0)
+        {
+          int cnt = contiguous_iovecs (iov, iovcnt, &nbyte);
+          const void* buf = iov->iov_base;
+          if (nbyte < gather_size)
+            {
+              // Gather the following short runs.
+              std::uint8_t* q = bounce.data ();
+              std::size_t len = 0;
+              cnt = 0;
+              while (cnt < iovcnt)
+                {
+                  int n = contiguous_iovecs (iov + cnt, iovcnt - cnt, &nbyte);
+                  if (len + nbyte > gather_size)
+                    {
+                      break;
+                    }
+                  std::memcpy (q + len, iov[cnt].iov_base, nbyte);
+                  len += nbyte;
+                  cnt += n;
+                }
+              buf = q;
+              nbyte = len;
+            }
+
+          ssize_t ret = do_pwrite (buf, nbyte, offset);
+          if (ret < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+          done += static_cast<std::size_t> (ret);
+          offset += ret;
+          if (static_cast<std::size_t> (ret) < nbyte)
+            {
+              break; // Short write, do not leave gaps.
+            }
+
+          iov += cnt;
+          iovcnt -= cnt;
+        }
+
+      // The offset is updated by the caller.
+      return static_cast<ssize_t> (done);
+    }
+
+    /**
+     * @details
+     * The entire vector is checked before any transfer, so a
+     * vector that does not fit does not leave a partial write
+     * behind. As for `read()` and `write()`, neither the offset
+     * nor the segments need to be block aligned.
+     */
+    ssize_t
+    block_device_impl::validate_iovecs (const iovec* iov, int iovcnt)
+    {
+      constexpr auto max
+          = static_cast<std::size_t> (std::numeric_limits<ssize_t>::max ());
 
-      if (blknum + nblocks > num_blocks_)
+      std::size_t total = 0;
+      for (int i = 0; i < iovcnt; ++i)
+        {
+          if (iov[i].iov_len > max - total)
+            {
+              errno = EINVAL;
+              return -1;
+            }
+          total += iov[i].iov_len;
+        }
+
+      if (!validate_range (offset_, total))
         {
           errno = EINVAL;
           return -1;
         }
 
-      ssize_t ret = do_read_block (buf, blknum, nblocks);
-      if (ret >= 0)
+      return static_cast<ssize_t> (total);
+    }
+
+    /**
+     * @details
+     * The check is done in blocks, so it does not wrap around
+     * for devices larger than the address space.
+     */
+    bool
+    block_device_impl::validate_range (off_t offset, std::size_t nbyte) const
+    {
+      const std::size_t size = block_logical_size_bytes_;
+      if ((size == 0) || (offset < 0))
         {
-          ret *= static_cast<ssize_t> (block_logical_size_bytes_);
+          return false;
         }
-      return ret;
+
+      const auto first = static_cast<std::uintmax_t> (offset) / size;
+      if (first > num_blocks_)
+        {
+          return false;
+        }
+      auto blknum = static_cast<blknum_t> (first);
+      auto skip = static_cast<std::size_t> (
+          static_cast<std::uintmax_t> (offset) % size);
+
+      // The blocks touched, rounded up, without overflow.
+      std::size_t nblocks
+          = nbyte / size + (skip + nbyte % size + size - 1) / size;
+
+      return nblocks <= num_blocks_ - blknum;
     }
 
+    /**
+     * @details
+     * Block devices are random access, so positional reads go
+     * straight to the driver, without the shared `offset_`.
+     *
+     * The offset and the size need not be block aligned; the
+     * aligned middle blocks are transferred directly into the
+     * caller buffer, and only the partial head and tail blocks
+     * are read into a bounce buffer. Both go through the
+     * read-ahead window, if enabled.
+     */
     ssize_t
-    block_device_impl::do_write (const void* buf, std::size_t nbyte)
+    block_device_impl::do_pread (void* buf, std::size_t nbyte, off_t offset)
     {
 #if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
-      trace::printf ("block_device_impl::%s(%p, %u) @%p\n", __func__, buf,
-                     nbyte, this);
+      trace::printf ("block_device_impl::%s(%p, %u, %d) @%p\n", __func__, buf,
+                     nbyte, offset, this);
 #endif
 
-      if ((block_logical_size_bytes_ == 0)
-          || ((nbyte % block_logical_size_bytes_) != 0)
-          || ((static_cast<std::size_t> (offset_) % block_logical_size_bytes_)
-              != 0))
+      if (!validate_range (offset, nbyte))
         {
           errno = EINVAL;
           return -1;
         }
 
-      std::size_t nblocks = nbyte / block_logical_size_bytes_;
-      blknum_t blknum
-          = static_cast<std::size_t> (offset_) / block_logical_size_bytes_;
+      const std::size_t size = block_logical_size_bytes_;
+
+      auto* p = static_cast<std::uint8_t*> (buf);
+      // Divided before narrowing, offsets may exceed std::size_t.
+      auto blknum = static_cast<blknum_t> (
+          static_cast<std::uintmax_t> (offset) / size);
+      auto skip = static_cast<std::size_t> (
+          static_cast<std::uintmax_t> (offset) % size);
 
-      if (blknum + nblocks > num_blocks_)
+      std::size_t done = 0;
+      if ((skip != 0) && (nbyte > 0))
+        {
+          std::size_t n = size - skip;
+          if (n > nbyte)
+            {
+              n = nbyte;
+            }
+          if (read_partial (p, blknum, skip, n) < 0)
+            {
+              return -1;
+            }
+          done = n;
+          ++blknum;
+        }
+
+      std::size_t nblocks = (nbyte - done) / size;
+      if (nblocks > 0)
+        {
+          ssize_t ret = read_blocks (p + done, blknum, nblocks);
+          if (ret < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+          done += static_cast<std::size_t> (ret) * size;
+          if (static_cast<std::size_t> (ret) < nblocks)
+            {
+              return static_cast<ssize_t> (done);
+            }
+          blknum += nblocks;
+        }
+
+      if (done < nbyte)
+        {
+          if (read_partial (p + done, blknum, 0, nbyte - done) < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : -1;
+            }
+          done = nbyte;
+        }
+
+      return static_cast<ssize_t> (done);
+    }
+
+    /**
+     * @details
+     * As for reads, only the partial head and tail blocks go
+     * through a bounce buffer, with a read-modify-write.
+     */
+    ssize_t
+    block_device_impl::do_pwrite (const void* buf, std::size_t nbyte,
+                                  off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_BLOCK_DEVICE)
+      trace::printf ("block_device_impl::%s(%p, %u, %d) @%p\n", __func__, buf,
+                     nbyte, offset, this);
+#endif
+
+      if (!validate_range (offset, nbyte))
         {
           errno = EINVAL;
           return -1;
         }
 
-      ssize_t ret = do_write_block (buf, blknum, nblocks);
-      if (ret >= 0)
+      const std::size_t size = block_logical_size_bytes_;
+
+      auto* p = static_cast<const std::uint8_t*> (buf);
+      // Divided before narrowing, offsets may exceed std::size_t.
+      auto blknum = static_cast<blknum_t> (
+          static_cast<std::uintmax_t> (offset) / size);
+      auto skip = static_cast<std::size_t> (
+          static_cast<std::uintmax_t> (offset) % size);
+
+      std::size_t done = 0;
+      if ((skip != 0) && (nbyte > 0))
         {
-          ret *= static_cast<ssize_t> (block_logical_size_bytes_);
+          std::size_t n = size - skip;
+          if (n > nbyte)
+            {
+              n = nbyte;
+            }
+          if (write_partial (p, blknum, skip, n) < 0)
+            {
+              return -1;
+            }
+          done = n;
+          ++blknum;
         }
-      return ret;
+
+      std::size_t nblocks = (nbyte - done) / size;
+      if (nblocks > 0)
+        {
+          read_ahead_invalidate (blknum, nblocks);
+
+          ssize_t ret = do_write_block (p + done, blknum, nblocks);
+          if (ret < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+          done += static_cast<std::size_t> (ret) * size;
+          if (static_cast<std::size_t> (ret) < nblocks)
+            {
+              return static_cast<ssize_t> (done);
+            }
+          blknum += nblocks;
+        }
+
+      if (done < nbyte)
+        {
+          if (write_partial (p + done, blknum, 0, nbyte - done) < 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : -1;
+            }
+          done = nbyte;
+        }
+
+      return static_cast<ssize_t> (done);
+    }
+
+    ssize_t
+    block_device_impl::read_blocks (void* buf, blknum_t blknum,
+                                    std::size_t nblocks)
+    {
+      if (read_ahead_blocks_ > 0)
+        {
+          return read_ahead (buf, blknum, nblocks);
+        }
+      return do_read_block (buf, blknum, nblocks);
+    }
+
+    int
+    block_device_impl::read_partial (void* buf, blknum_t blknum,
+                                     std::size_t skip, std::size_t nbyte)
+    {
+      bounce_buffer bounce{ block_logical_size_bytes_ };
+      errno = 0;
+      // Via the read-ahead, so unaligned streaming reads, whose
+      // edge blocks always come here, are served from the window.
+      if (read_blocks (bounce.data (), blknum, 1) != 1)
+        {
+          if (errno == 0)
+            {
+              errno = EIO;
+            }
+          return -1;
+        }
+
+      std::memcpy (buf, bounce.data () + skip, nbyte);
+      return 0;
+    }
+
+    int
+    block_device_impl::write_partial (const void* buf, blknum_t blknum,
+                                      std::size_t skip, std::size_t nbyte)
+    {
+      bounce_buffer bounce{ block_logical_size_bytes_ };
+      errno = 0;
+      // Directly from the driver; going via the read-ahead would
+      // refill the window only to invalidate it below.
+      if (do_read_block (bounce.data (), blknum, 1) != 1)
+        {
+          if (errno == 0)
+            {
+              errno = EIO;
+            }
+          return -1;
+        }
+
+      std::memcpy (bounce.data () + skip, buf, nbyte);
+
+      read_ahead_invalidate (blknum, 1);
+      errno = 0;
+      if (do_write_block (bounce.data (), blknum, 1) != 1)
+        {
+          if (errno == 0)
+            {
+              errno = EIO;
+            }
+          return -1;
+        }
+      return 0;
+    }
+
+    /**
+     * @details
+     * Blocks already in the read-ahead buffer are copied from it.
+     * If the read continues the previous one and is shorter than
+     * the window, the buffer is refilled with a full window, so a
+     * streaming reader pays the per-command overhead of the device
+     * once per window, not once per call. Random or large reads go
+     * directly to the driver.
+     *
+     * There is one window per device, i.e. per open file
+     * description, since the device is opened once and shared by
+     * all its file descriptors.
+     */
+    ssize_t
+    block_device_impl::read_ahead (void* buf, blknum_t blknum,
+                                   std::size_t nblocks)
+    {
+      auto* p = static_cast<std::uint8_t*> (buf);
+      const std::size_t size = block_logical_size_bytes_;
+
+      // Unaligned records may continue in the last block read.
+      bool sequential = (blknum == sequential_next_)
+                        || (blknum + 1 == sequential_next_);
+      sequential_next_ = blknum + nblocks;
+
+      std::size_t done = 0;
+      while (done < nblocks)
+        {
+          blknum_t b = blknum + done;
+          if ((b >= read_ahead_first_)
+              && (b < read_ahead_first_ + read_ahead_count_))
+            {
+              std::size_t n = read_ahead_first_ + read_ahead_count_ - b;
+              if (n > nblocks - done)
+                {
+                  n = nblocks - done;
+                }
+              std::memcpy (p + done * size,
+                           read_ahead_buffer_ + (b - read_ahead_first_) * size,
+                           n * size);
+              done += n;
+              continue;
+            }
+
+          std::size_t remaining = nblocks - done;
+          if (!sequential || (remaining >= read_ahead_blocks_))
+            {
+              ssize_t ret = do_read_block (p + done * size, b, remaining);
+              if (ret < 0)
+                {
+                  return (done > 0) ? static_cast<ssize_t> (done) : ret;
+                }
+              done += static_cast<std::size_t> (ret);
+              break;
+            }
+
+          if (read_ahead_buffer_ == nullptr)
+            {
+              read_ahead_buffer_ = new std::uint8_t[read_ahead_blocks_ * size];
+            }
+
+          std::size_t n = read_ahead_blocks_;
+          if (n > num_blocks_ - b)
+            {
+              n = num_blocks_ - b;
+            }
+          read_ahead_count_ = 0;
+          ssize_t ret = do_read_block (read_ahead_buffer_, b, n);
+          if (ret <= 0)
+            {
+              return (done > 0) ? static_cast<ssize_t> (done) : ret;
+            }
+          read_ahead_first_ = b;
+          read_ahead_count_ = static_cast<std::size_t> (ret);
+        }
+
+      return static_cast<ssize_t> (done);
+    }
+
+    void
+    block_device_impl::read_ahead_invalidate (blknum_t blknum,
+                                              std::size_t nblocks)
+    {
+      if ((blknum < read_ahead_first_ + read_ahead_count_)
+          && (read_ahead_first_ < blknum + nblocks))
+        {
+          read_ahead_count_ = 0;
+        }
+    }
+
+    void
+    block_device_impl::read_ahead_resize (std::size_t nblocks)
+    {
+      delete[] read_ahead_buffer_;
+      read_ahead_buffer_ = nullptr;
+      read_ahead_count_ = 0;
+
+      read_ahead_blocks_ = nblocks;
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * Take a free buffer from the pool, or, if none is free or
+     * the blocks are larger than the pool buffers, allocate one.
+     */
+    block_device_impl::bounce_buffer::bounce_buffer (std::size_t size)
+    {
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS > 0
+      if (size <= pool_buffer_size__)
+        {
+          io_waiter::critical_section cs;
+
+          for (unsigned int i = 0; i < pool_buffers__; ++i)
+            {
+              if ((pool_used__ & (1u << i)) == 0)
+                {
+                  pool_used__ |= (1u << i);
+                  index_ = static_cast<int> (i);
+                  data_ = pool__[i];
+                  return;
+                }
+            }
+        }
+#endif
+
+      data_ = new std::uint8_t[size];
+    }
+
+    block_device_impl::bounce_buffer::~bounce_buffer ()
+    {
+      if (index_ < 0)
+        {
+          delete[] data_;
+          return;
+        }
+
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_BLOCK_DEVICE_BOUNCE_BUFFERS > 0
+      io_waiter::critical_section cs;
+
+      pool_used__ &= ~(1u << index_);
+#endif
     }
 
     // ==========================================================================
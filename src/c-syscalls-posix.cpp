@@ -116,21 +116,54 @@ __posix_close (int fildes)
 {
   // The flow is identical for all POSIX functions: identify the C++
   // object and call the corresponding C++ method.
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
       return -1;
     }
+
+  // Only the last descriptor referring to the io closes it.
+  int remaining = posix::file_descriptors_manager::deallocate (fildes);
+  if (remaining != 0)
+    {
+      return (remaining < 0) ? -1 : 0;
+    }
   return io->close ();
 }
 
+/**
+ * @details
+ * The `dup()` function shall return a new file descriptor, the
+ * lowest numbered available, referring to the same open file
+ * description as _fildes_; the offset and the status are shared.
+ */
+int
+__posix_dup (int fildes)
+{
+  return posix::file_descriptors_manager::dup (fildes);
+}
+
+/**
+ * @details
+ * The `dup2()` function shall cause the file descriptor _fildes2_ to
+ * refer to the same open file description as _fildes_, closing
+ * _fildes2_ first if it was open.
+ */
+int
+__posix_dup2 (int fildes, int fildes2)
+{
+  return posix::file_descriptors_manager::dup2 (fildes, fildes2);
+}
+
 // ----------------------------------------------------------------------------
 
 ssize_t
 __posix_read (int fildes, void* buf, size_t nbyte)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       // STDIN
@@ -147,7 +180,8 @@ __posix_read (int fildes, void* buf, size_t nbyte)
 ssize_t
 __posix_write (int fildes, const void* buf, size_t nbyte)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       // STDOUT & STDERR
@@ -161,10 +195,24 @@ __posix_write (int fildes, const void* buf, size_t nbyte)
   return io->write (buf, nbyte);
 }
 
+ssize_t
+__posix_readv (int fildes, const iovec* iov, int iovcnt)
+{
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
+  if (io == nullptr)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  return io->readv (iov, iovcnt);
+}
+
 ssize_t
 __posix_writev (int fildes, const iovec* iov, int iovcnt)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -173,10 +221,44 @@ __posix_writev (int fildes, const iovec* iov, int iovcnt)
   return io->writev (iov, iovcnt);
 }
 
+ssize_t
+__posix_pread (int fildes, void* buf, size_t nbyte, off_t offset)
+{
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
+  if (io == nullptr)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  return io->pread (buf, nbyte, offset);
+}
+
+ssize_t
+__posix_pwrite (int fildes, const void* buf, size_t nbyte, off_t offset)
+{
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
+  if (io == nullptr)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  return io->pwrite (buf, nbyte, offset);
+}
+
+int
+__posix_select (int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds,
+                timeval* timeout)
+{
+  return posix::select (nfds, readfds, writefds, errorfds, timeout);
+}
+
 int
 __posix_ioctl (int fildes, int request, ...)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -202,7 +284,8 @@ __posix_ioctl (int fildes, int request, ...)
 off_t
 __posix_lseek (int fildes, off_t offset, int whence)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF; // Fildes is not an open file descriptor.
@@ -227,7 +310,8 @@ __posix_lseek (int fildes, off_t offset, int whence)
 int
 __posix_isatty (int fildes)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       if (fildes <= 2)
@@ -243,7 +327,8 @@ __posix_isatty (int fildes)
 int
 __posix_tcdrain (int fildes)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF; // Fildes is not an open file descriptor.
@@ -263,7 +348,8 @@ __posix_tcdrain (int fildes)
 int
 __posix_tcgetattr (int fildes, termios* termios_p)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF; // Fildes is not an open file descriptor.
@@ -283,7 +369,8 @@ __posix_tcgetattr (int fildes, termios* termios_p)
 int
 __posix_tcsetattr (int fildes, int optional_actions, const termios* termios_p)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF; // Fildes is not an open file descriptor.
@@ -304,7 +391,8 @@ __posix_tcsetattr (int fildes, int optional_actions, const termios* termios_p)
 int
 __posix_tcflush (int fildes, int queue_selector)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF; // Fildes is not an open file descriptor.
@@ -324,7 +412,8 @@ __posix_tcflush (int fildes, int queue_selector)
 int
 __posix_tcsendbreak (int fildes, int duration)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF; // Fildes is not an open file descriptor.
@@ -344,7 +433,8 @@ __posix_tcsendbreak (int fildes, int duration)
 int
 __posix_fcntl (int fildes, int cmd, ...)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -362,7 +452,8 @@ __posix_fcntl (int fildes, int cmd, ...)
 int
 __posix_fstat (int fildes, struct stat* buf)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -374,7 +465,8 @@ __posix_fstat (int fildes, struct stat* buf)
 int
 __posix_fstatvfs (int fildes, struct statvfs* buf)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -394,7 +486,8 @@ __posix_fstatvfs (int fildes, struct statvfs* buf)
 int
 __posix_ftruncate (int fildes, off_t length)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -414,7 +507,8 @@ __posix_ftruncate (int fildes, off_t length)
 int
 __posix_fsync (int fildes)
 {
-  auto* const io = posix::file_descriptors_manager::io (fildes);
+  posix::file_descriptors_manager::pinned_io pin{ fildes };
+  auto* const io = pin.get ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -587,7 +681,8 @@ __posix_socketpair (int domain, int type, int protocol, int socket_vector[2])
 int
 __posix_accept (int socket, sockaddr* address, socklen_t* address_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -600,7 +695,8 @@ __posix_accept (int socket, sockaddr* address, socklen_t* address_len)
 int
 __posix_bind (int socket, const sockaddr* address, socklen_t address_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -612,7 +708,8 @@ __posix_bind (int socket, const sockaddr* address, socklen_t address_len)
 int
 __posix_connect (int socket, const sockaddr* address, socklen_t address_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -624,7 +721,8 @@ __posix_connect (int socket, const sockaddr* address, socklen_t address_len)
 int
 __posix_getpeername (int socket, sockaddr* address, socklen_t* address_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -636,7 +734,8 @@ __posix_getpeername (int socket, sockaddr* address, socklen_t* address_len)
 int
 __posix_getsockname (int socket, sockaddr* address, socklen_t* address_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -649,7 +748,8 @@ int
 __posix_getsockopt (int socket, int level, int option_name, void* option_value,
                     socklen_t* option_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -661,7 +761,8 @@ __posix_getsockopt (int socket, int level, int option_name, void* option_value,
 int
 __posix_listen (int socket, int backlog)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -673,7 +774,8 @@ __posix_listen (int socket, int backlog)
 ssize_t
 __posix_recv (int socket, void* buffer, size_t length, int flags)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -686,7 +788,8 @@ ssize_t
 __posix_recvfrom (int socket, void* buffer, size_t length, int flags,
                   sockaddr* address, socklen_t* address_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -698,7 +801,8 @@ __posix_recvfrom (int socket, void* buffer, size_t length, int flags,
 ssize_t
 __posix_recvmsg (int socket, msghdr* message, int flags)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -710,7 +814,8 @@ __posix_recvmsg (int socket, msghdr* message, int flags)
 ssize_t
 __posix_send (int socket, const void* buffer, size_t length, int flags)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -722,7 +827,8 @@ __posix_send (int socket, const void* buffer, size_t length, int flags)
 ssize_t
 __posix_sendmsg (int socket, const msghdr* message, int flags)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -735,7 +841,8 @@ ssize_t
 __posix_sendto (int socket, const void* message, size_t length, int flags,
                 const sockaddr* dest_addr, socklen_t dest_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -748,7 +855,8 @@ int
 __posix_setsockopt (int socket, int level, int option_name,
                     const void* option_value, socklen_t option_len)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -760,7 +868,8 @@ __posix_setsockopt (int socket, int level, int option_name,
 int
 __posix_shutdown (int socket, int how)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -772,7 +881,8 @@ __posix_shutdown (int socket, int how)
 int
 __posix_sockatmark (int socket)
 {
-  auto* const io = posix::file_descriptors_manager::socket (socket);
+  posix::file_descriptors_manager::pinned_io pin{ socket };
+  auto* const io = pin.socket ();
   if (io == nullptr)
     {
       errno = EBADF;
@@ -827,14 +937,6 @@ __posix_gettimeofday (struct timeval* ptimeval, void* ptimezone)
 }
 #endif
 
-int
-__posix_select (int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds,
-                timeval* timeout)
-{
-  errno = ENOSYS; // Not implemented
-  return -1;
-}
-
 clock_t
 __posix_times (tms* buf)
 {
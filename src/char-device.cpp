@@ -62,7 +62,7 @@ namespace micro_os_plus
       trace::printf ("char_device::%s() @%p %s\n", __func__, this, name_);
 #endif
 
-      registry_links_.unlink ();
+      device_registry<device>::unlink (this);
 
       name_ = nullptr;
     }
@@ -101,6 +101,23 @@ namespace micro_os_plus
       errno = ENOSYS; // Not implemented
     }
 
+    /**
+     * @details
+     * Report the events the driver recorded with `notify_events()`
+     * and did not yet clear with `clear_events()`; a device is
+     * ready only after the driver says so. Drivers which cannot
+     * track readiness must override this function.
+     */
+    io::events_t
+    char_device_impl::do_poll_events (void)
+    {
+      if (!do_is_opened ())
+        {
+          return io::event::hangup;
+        }
+      return pending_events ();
+    }
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus
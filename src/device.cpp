@@ -26,6 +26,7 @@
  */
 
 #include <micro-os-plus/posix-io/device.h>
+#include <micro-os-plus/posix-io/device-registry.h>
 #include <micro-os-plus/posix/sys/ioctl.h>
 
 #include <cstring>
@@ -49,6 +50,14 @@ namespace micro_os_plus
 {
   namespace posix
   {
+    // ------------------------------------------------------------------------
+
+    __attribute__ ((weak)) const static_name_view<device>*
+    static_device_table (void)
+    {
+      return nullptr;
+    }
+
     // ========================================================================
 
     device::device (device_impl& impl, type t, const char* name)
@@ -66,7 +75,7 @@ namespace micro_os_plus
       trace::printf ("device::%s() @%p\n", __func__, this);
 #endif
 
-      registry_links_.unlink ();
+      device_registry<device>::unlink (this);
 
       name_ = nullptr;
     }
@@ -0,0 +1,608 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/event-poller.h>
+#include <micro-os-plus/posix-io/file-descriptors-manager.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wsuggest-final-methods"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+      constexpr io::events_t events_mask
+          = io::event::readable | io::event::writable | io::event::error
+            | io::event::hangup;
+
+      // Errors and hang ups are always reported, as in epoll.
+      inline io::events_t
+      requested_events (io::events_t events)
+      {
+        if ((events & events_mask) == 0)
+          {
+            return 0; // Disabled (one shot).
+          }
+        return (events & events_mask) | io::event::error | io::event::hangup;
+      }
+    } // namespace
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    event_poller::event_poller (event_poller_impl& impl)
+        : io{ impl, type::event_poller }
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s()=@%p\n", __func__, this);
+#endif
+    }
+
+    event_poller::~event_poller ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s() @%p\n", __func__, this);
+#endif
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    event_poller::open (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s() @%p\n", __func__, this);
+#endif
+
+      if (impl ().is_opened_)
+        {
+          errno = EBUSY;
+          return -1;
+        }
+
+      errno = 0;
+
+      impl ().is_opened_ = true;
+
+      if (alloc_file_descriptor () == nullptr)
+        {
+          return -1;
+        }
+      return file_descriptor ();
+    }
+
+    int
+    event_poller::add (int fildes, io::events_t events, void* data)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s(%d, 0x%X) @%p\n", __func__, fildes,
+                     events, this);
+#endif
+
+      file_descriptors_manager::pinned_io pin{ fildes };
+      auto* const target = pin.get ();
+      if ((target == nullptr) || !impl ().do_is_opened ())
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      if (target == this)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return impl ().do_add (target, events, data);
+    }
+
+    int
+    event_poller::modify (int fildes, io::events_t events, void* data)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s(%d, 0x%X) @%p\n", __func__, fildes,
+                     events, this);
+#endif
+
+      file_descriptors_manager::pinned_io pin{ fildes };
+      auto* const target = pin.get ();
+      if ((target == nullptr) || !impl ().do_is_opened ())
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return impl ().do_modify (target, events, data);
+    }
+
+    int
+    event_poller::remove (int fildes)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s(%d) @%p\n", __func__, fildes, this);
+#endif
+
+      file_descriptors_manager::pinned_io pin{ fildes };
+      auto* const target = pin.get ();
+      if ((target == nullptr) || !impl ().do_is_opened ())
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return impl ().do_remove (target);
+    }
+
+    int
+    event_poller::wait (event* events, int max_events, timespec* timeout)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller::%s(%p, %d) @%p\n", __func__, events,
+                     max_events, this);
+#endif
+
+      if (events == nullptr)
+        {
+          errno = EFAULT;
+          return -1;
+        }
+
+      if (max_events <= 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return impl ().do_wait (events, max_events, timeout);
+    }
+
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    /**
+     * @details
+     * Called by the driver, possibly from an interrupt, with the
+     * listeners list locked. Only link the item into the ready list
+     * and wake up the poller; the actual state is read later, by
+     * the waiting thread.
+     */
+    void
+    event_poller_impl::item::notify (io_impl& impl, io::events_t events)
+    {
+      if ((events & requested_events (events_)) == 0)
+        {
+          return;
+        }
+
+      if (!ready_links_.linked ())
+        {
+          poller_->ready_list_.link (*this);
+        }
+      poller_->waiter_.wakeup ();
+    }
+
+    void
+    event_poller_impl::item::detach (io_impl& impl)
+    {
+      // The io was closed; the item is no longer subscribed.
+      poller_->release_item (this);
+    }
+
+#pragma GCC diagnostic pop
+
+    // ========================================================================
+
+    event_poller_impl::event_poller_impl (std::size_t max_items)
+        : max_items_ (max_items)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller_impl::%s(%u)=@%p\n", __func__, max_items,
+                     this);
+#endif
+
+      assert (max_items > 0);
+
+      items_array_ = new item[max_items_];
+      for (std::size_t i = 0; i < max_items_; ++i)
+        {
+          items_array_[i].poller_ = this;
+          free_list_.link (items_array_[i]);
+        }
+    }
+
+    event_poller_impl::~event_poller_impl ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_EVENT_POLLER)
+      trace::printf ("event_poller_impl::%s() @%p\n", __func__, this);
+#endif
+
+      do_close ();
+
+      delete[] items_array_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    bool
+    event_poller_impl::do_is_opened (void)
+    {
+      return is_opened_;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    ssize_t
+    event_poller_impl::do_read (void* buf, std::size_t nbyte)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+    ssize_t
+    event_poller_impl::do_write (const void* buf, std::size_t nbyte)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+    off_t
+    event_poller_impl::do_lseek (off_t offset, int whence)
+    {
+      errno = ESPIPE;
+      return -1;
+    }
+
+#pragma GCC diagnostic pop
+
+    /**
+     * @details
+     * Remove all registrations and wake up the waiting thread.
+     */
+    int
+    event_poller_impl::do_close (void)
+    {
+      for (std::size_t i = 0; i < max_items_; ++i)
+        {
+          item* it = &items_array_[i];
+          if (it->io_ != nullptr)
+            {
+              it->io_->impl ().unsubscribe (*it);
+              release_item (it);
+            }
+        }
+
+      is_opened_ = false;
+      waiter_.wakeup ();
+
+      return 0;
+    }
+
+    io::events_t
+    event_poller_impl::do_poll_events (void)
+    {
+      io_waiter::critical_section cs;
+
+      return ready_list_.empty () ? io::event::none : io::event::readable;
+    }
+
+    int
+    event_poller_impl::do_add (class io* io, io::events_t events, void* data)
+    {
+      if (find_item (io) != nullptr)
+        {
+          errno = EEXIST;
+          return -1;
+        }
+
+      item* it;
+      {
+        io_waiter::critical_section cs;
+
+        if (free_list_.empty ())
+          {
+            errno = ENOSPC;
+            return -1;
+          }
+        it = free_list_.unlink_head ();
+      }
+
+      it->io_ = io;
+      it->events_ = events;
+      it->data_ = data;
+
+      io->impl ().subscribe (*it);
+
+      check_ready (it);
+
+      return 0;
+    }
+
+    int
+    event_poller_impl::do_modify (class io* io, io::events_t events,
+                                  void* data)
+    {
+      item* it = find_item (io);
+      if (it == nullptr)
+        {
+          errno = ENOENT;
+          return -1;
+        }
+
+      {
+        io_waiter::critical_section cs;
+
+        it->events_ = events;
+        it->data_ = data;
+      }
+
+      check_ready (it);
+
+      return 0;
+    }
+
+    int
+    event_poller_impl::do_remove (class io* io)
+    {
+      item* it = find_item (io);
+      if (it == nullptr)
+        {
+          errno = ENOENT;
+          return -1;
+        }
+
+      io->impl ().unsubscribe (*it);
+      release_item (it);
+
+      return 0;
+    }
+
+    /**
+     * @details
+     * Only the items in the ready list are inspected; level
+     * triggered items which are still ready are queued again,
+     * after all others, so a busy descriptor cannot starve
+     * the rest.
+     */
+    int
+    event_poller_impl::do_wait (event_poller::event* events, int max_events,
+                                timespec* timeout)
+    {
+      while (true)
+        {
+          // A notification after this point makes wait() return at once.
+          waiter_.arm ();
+
+          int count = collect_events (events, max_events);
+          if (count > 0)
+            {
+              return count;
+            }
+
+          if (!is_opened_)
+            {
+              errno = EBADF;
+              return -1;
+            }
+
+          if ((timeout != nullptr) && (timeout->tv_sec == 0)
+              && (timeout->tv_nsec == 0))
+            {
+              return 0;
+            }
+
+          if (waiter_.wait (timeout) < 0)
+            {
+              if (errno == ETIMEDOUT)
+                {
+                  errno = 0;
+                  return 0;
+                }
+              return -1;
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------
+
+    event_poller_impl::item*
+    event_poller_impl::find_item (class io* io)
+    {
+      for (std::size_t i = 0; i < max_items_; ++i)
+        {
+          if (items_array_[i].io_ == io)
+            {
+              return &items_array_[i];
+            }
+        }
+      return nullptr;
+    }
+
+    void
+    event_poller_impl::check_ready (item* it)
+    {
+      if ((it->io_->poll_events () & requested_events (it->events_)) == 0)
+        {
+          return;
+        }
+
+      io_waiter::critical_section cs;
+
+      if (!it->ready_links_.linked ())
+        {
+          ready_list_.link (*it);
+        }
+      waiter_.wakeup ();
+    }
+
+    void
+    event_poller_impl::release_item (item* it)
+    {
+      io_waiter::critical_section cs;
+
+      if (it->ready_links_.linked ())
+        {
+          it->ready_links_.unlink ();
+        }
+
+      it->io_ = nullptr;
+      it->events_ = 0;
+      it->data_ = nullptr;
+
+      if (!it->busy_)
+        {
+          free_list_.link (*it);
+        }
+    }
+
+    int
+    event_poller_impl::collect_events (event_poller::event* events,
+                                       int max_events)
+    {
+      items_list requeue_list;
+
+      int count = 0;
+      while (count < max_events)
+        {
+          item* it;
+          class io* target;
+          io::events_t requested;
+          {
+            io_waiter::critical_section cs;
+
+            if (ready_list_.empty ())
+              {
+                break;
+              }
+            it = ready_list_.unlink_head ();
+
+            // Pin the item; a concurrent close() must not recycle
+            // it while its io is polled below.
+            it->busy_ = true;
+            target = it->io_;
+            requested = requested_events (it->events_);
+          }
+
+          io::events_t ready = target->poll_events () & requested;
+
+          io_waiter::critical_section cs;
+
+          it->busy_ = false;
+          if (it->io_ == nullptr)
+            {
+              // Released while polled; complete the release.
+              free_list_.link (*it);
+              continue;
+            }
+
+          if (ready == 0)
+            {
+              // Stale notification; the next one will queue it again.
+              continue;
+            }
+
+          events[count].events = ready;
+          events[count].data = it->data_;
+          ++count;
+
+          if (it->events_ & event_poller::one_shot)
+            {
+              // Keep only the flags; disabled until modified.
+              it->events_ &= ~events_mask;
+            }
+          else if (!(it->events_ & event_poller::edge_triggered))
+            {
+              // Level triggered; a notification may have already
+              // queued it again.
+              if (!it->ready_links_.linked ())
+                {
+                  requeue_list.link (*it);
+                }
+            }
+        }
+
+      io_waiter::critical_section cs;
+
+      while (!requeue_list.empty ())
+        {
+          ready_list_.link (*requeue_list.unlink_head ());
+        }
+
+      return count;
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
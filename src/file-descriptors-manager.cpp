@@ -55,49 +55,182 @@ namespace micro_os_plus
 
     std::size_t file_descriptors_manager::size__;
 
-    io** file_descriptors_manager::descriptors_array__;
+    std::atomic<file_descriptors_manager::page*>*
+        file_descriptors_manager::pages__;
+
+    std::size_t file_descriptors_manager::pages_count__;
+
+    std::atomic<std::size_t> file_descriptors_manager::mapped_pages__;
+
+    file_descriptors_manager::page* file_descriptors_manager::retired__;
+
+    std::atomic_flag file_descriptors_manager::shrinking__
+        = ATOMIC_FLAG_INIT;
+
+    std::atomic<std::size_t> file_descriptors_manager::used__;
+
+    std::atomic<std::size_t> file_descriptors_manager::type_used__[types__];
+
+    std::atomic<std::size_t>* file_descriptors_manager::lookups__;
 
     /**
      * @endcond
      */
 
     // ========================================================================
-    file_descriptors_manager::file_descriptors_manager (std::size_t size)
+
+    file_descriptors_manager::pinned_io::pinned_io (int fildes)
+        : io_ (pin (fildes))
+    {
+    }
+
+    file_descriptors_manager::pinned_io::~pinned_io ()
     {
-      trace::printf ("file_descriptors_manager::%s(%d)=%p\n", __func__, size,
-                     this);
+      if (io_ != nullptr)
+        {
+          unpin (io_);
+        }
+    }
+
+    socket*
+    file_descriptors_manager::pinned_io::socket (void) const
+    {
+      if ((io_ == nullptr) || (io_->get_type () != io::type::socket))
+        {
+          return nullptr;
+        }
+      return reinterpret_cast<class socket*> (io_);
+    }
+
+    // ========================================================================
+
+    /**
+     * @details
+     * Only the first level (one pointer per page) is allocated for
+     * the full size; the pages themselves are mapped when needed.
+     */
+    file_descriptors_manager::file_descriptors_manager (std::size_t size,
+                                                        std::size_t initial)
+    {
+      trace::printf ("file_descriptors_manager::%s(%d,%d)=%p\n", __func__,
+                     size, initial, this);
 
       assert (size > 0);
 
       size__ = size + reserved__; // Add space for standard files.
-      descriptors_array__ = new class io*[size__];
 
-      for (std::size_t i = 0; i < file_descriptors_manager::size (); ++i)
+      pages_count__ = (size__ + slots_per_page__ - 1) / slots_per_page__;
+      pages__ = new std::atomic<page*>[pages_count__];
+      lookups__ = new std::atomic<std::size_t>[pages_count__];
+      for (std::size_t p = 0; p < pages_count__; ++p)
+        {
+          pages__[p].store (nullptr, std::memory_order_relaxed);
+          lookups__[p].store (0, std::memory_order_relaxed);
+        }
+      mapped_pages__.store (0, std::memory_order_relaxed);
+      retired__ = nullptr;
+
+      // The first page holds the standard descriptors, and is
+      // always mapped.
+      std::size_t pages
+          = (initial + reserved__ + slots_per_page__ - 1) / slots_per_page__;
+      for (std::size_t p = 0; p < pages && p < pages_count__; ++p)
+        {
+          map_page (p);
+        }
+
+      used__.store (reserved__);
+      for (std::size_t i = 0; i < types__; ++i)
         {
-          descriptors_array__[i] = nullptr;
+          type_used__[i].store (0, std::memory_order_relaxed);
         }
     }
 
     file_descriptors_manager::~file_descriptors_manager ()
     {
-      trace::printf ("file_descriptors_manager::%s(%) @%p\n", __func__, this);
+      trace::printf ("file_descriptors_manager::%s() @%p\n", __func__, this);
+
+      for (std::size_t p = 0; p < pages_count__; ++p)
+        {
+          delete pages__[p].exchange (nullptr, std::memory_order_relaxed);
+        }
+      free_retired ();
+
+      delete[] pages__;
+      pages__ = nullptr;
+      delete[] lookups__;
+      lookups__ = nullptr;
+      pages_count__ = 0;
+      mapped_pages__.store (0, std::memory_order_relaxed);
 
-      delete[] descriptors_array__;
       size__ = 0;
     }
 
     // ------------------------------------------------------------------------
 
+    /**
+     * @details
+     * Two acquire loads, the page and the slot, with no lock. The
+     * returned pointer is valid only as long as the descriptor is
+     * not closed; callers which may race with close() should
+     * use `pinned_io`.
+     */
     io*
     file_descriptors_manager::io (int fildes)
     {
       // Check if valid descriptor or buffer not yet initialised
       if ((fildes < 0) || (static_cast<std::size_t> (fildes) >= size__)
-          || (descriptors_array__ == nullptr))
+          || (pages__ == nullptr))
         {
           return nullptr;
         }
-      return descriptors_array__[fildes];
+
+      std::size_t i = static_cast<std::size_t> (fildes);
+      std::size_t p = i / slots_per_page__;
+
+      // Keep shrink() from freeing the page while it is read.
+      lookups__[p].fetch_add (1);
+      class io* io = load (i);
+      lookups__[p].fetch_sub (1);
+
+      return io;
+    }
+
+    /**
+     * @details
+     * A single lookup: the page counter covers only the short
+     * window between loading the slot and incrementing the pin
+     * count; a thread blocked for a long time in read() holds a
+     * pin only on its own io, and does not delay the reclamation
+     * of others.
+     */
+    io*
+    file_descriptors_manager::pin (int fildes)
+    {
+      if ((fildes < 0) || (static_cast<std::size_t> (fildes) >= size__)
+          || (pages__ == nullptr))
+        {
+          return nullptr;
+        }
+
+      std::size_t i = static_cast<std::size_t> (fildes);
+      std::size_t p = i / slots_per_page__;
+
+      lookups__[p].fetch_add (1);
+      class io* io = load (i);
+      if (io != nullptr)
+        {
+          io->pins_.fetch_add (1);
+        }
+      lookups__[p].fetch_sub (1);
+
+      return io;
+    }
+
+    void
+    file_descriptors_manager::unpin (class io* io)
+    {
+      io->pins_.fetch_sub (1, std::memory_order_release);
     }
 
     bool
@@ -124,23 +257,22 @@ namespace micro_os_plus
           return -1;
         }
 
-      for (std::size_t i = reserved__; i < size__; ++i)
+      io->descriptors_.fetch_add (1, std::memory_order_relaxed);
+      int fd = claim (io);
+      if (fd < 0)
         {
-          if (descriptors_array__[i] == nullptr)
-            {
-              descriptors_array__[i] = io;
-              io->file_descriptor (static_cast<int> (i));
-#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
-              trace::printf ("file_descriptors_manager::%s(%p) fd=%d\n",
-                             __func__, io, i);
-#endif
-              return static_cast<int> (i);
-            }
+          io->descriptors_.fetch_sub (1, std::memory_order_relaxed);
+          // Too many files open in system.
+          errno = ENFILE;
+          return -1;
         }
 
-      // Too many files open in system.
-      errno = ENFILE;
-      return -1;
+      io->file_descriptor (fd);
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
+      trace::printf ("file_descriptors_manager::%s(%p) fd=%d\n", __func__, io,
+                     fd);
+#endif
+      return fd;
     }
 
     int
@@ -159,11 +291,30 @@ namespace micro_os_plus
           return -1;
         }
 
-      descriptors_array__[fildes] = io;
+      std::size_t i = static_cast<std::size_t> (fildes);
+
       io->file_descriptor (fildes);
+      auto* const old_io = place (i, io);
+      io->descriptors_.fetch_add (1, std::memory_order_relaxed);
+      count (io, 1);
+
+      if (old_io != nullptr)
+        {
+          drop (old_io, i);
+        }
+
       return fildes;
     }
 
+    /**
+     * @details
+     * The slot is cleared first, so new lookups fail, then the
+     * bitmap bit is released, so the descriptor can be reused.
+     * If two threads close the same descriptor, only one succeeds.
+     *
+     * The io is not closed; this is left to the caller, when no
+     * other descriptor refers to it.
+     */
     int
     file_descriptors_manager::deallocate (int fildes)
     {
@@ -177,17 +328,200 @@ namespace micro_os_plus
           return -1;
         }
 
-      descriptors_array__[fildes]->clear_file_descriptor ();
-      descriptors_array__[fildes] = nullptr;
+      int remaining = release (static_cast<std::size_t> (fildes), nullptr);
+      if (remaining < 0)
+        {
+          errno = EBADF;
+          return -1;
+        }
+      return remaining;
+    }
+
+    int
+    file_descriptors_manager::deallocate (class io* io)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
+      trace::printf ("file_descriptors_manager::%s(%p)\n", __func__, io);
+#endif
+
+      while (io->descriptors_.load (std::memory_order_acquire) != 0)
+        {
+          // Usually the io has a single descriptor, which is known.
+          int fd = io->file_descriptor ();
+          if ((fd < 0) || (release (static_cast<std::size_t> (fd), io) < 0))
+            {
+              fd = find (io);
+              if (fd < 0)
+                {
+                  break;
+                }
+              release (static_cast<std::size_t> (fd), io);
+            }
+        }
+
+      io->clear_file_descriptor ();
       return 0;
     }
 
+    /**
+     * @details
+     * The new descriptor shares the io object, including the
+     * offset and the status; the io is closed only when the
+     * last descriptor referring to it is closed.
+     */
+    int
+    file_descriptors_manager::dup (int fildes)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
+      trace::printf ("file_descriptors_manager::%s(%d)\n", __func__, fildes);
+#endif
+
+      pinned_io pin{ fildes };
+      auto* const io = pin.get ();
+      if (io == nullptr)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      // Take the reference before publishing the descriptor.
+      if (!retain (io))
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      int fd = claim (io);
+      if (fd < 0)
+        {
+          if (io->descriptors_.fetch_sub (1, std::memory_order_acq_rel) == 1)
+            {
+              // All other descriptors were closed meanwhile.
+              io->close ();
+            }
+          errno = EMFILE;
+          return -1;
+        }
+
+      return fd;
+    }
+
+    /**
+     * @details
+     * The replacement is a single exchange of the slot, so there is
+     * no window when `fildes2` is unused and may be taken by
+     * another thread. Errors while closing the previous io are
+     * ignored, as required by POSIX.
+     */
+    int
+    file_descriptors_manager::dup2 (int fildes, int fildes2)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
+      trace::printf ("file_descriptors_manager::%s(%d, %d)\n", __func__,
+                     fildes, fildes2);
+#endif
+
+      if ((fildes2 < 0) || (static_cast<std::size_t> (fildes2) >= size__))
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      pinned_io pin{ fildes };
+      auto* const io = pin.get ();
+      if (io == nullptr)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      if (fildes == fildes2)
+        {
+          return fildes2;
+        }
+
+      if (!retain (io))
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      std::size_t i = static_cast<std::size_t> (fildes2);
+      auto* const old_io = place (i, io);
+      count (io, 1);
+
+      if ((old_io != nullptr) && (drop (old_io, i) == 0))
+        {
+          old_io->close ();
+        }
+
+      return fildes2;
+    }
+
+    /**
+     * @details
+     * Only trailing pages are given back, so the mapped descriptors
+     * remain a compact range. A page is first closed for allocation
+     * by setting all its bits, which succeeds only if no descriptor
+     * in it is used, then it is unlinked; its memory is freed when
+     * no lookup is in progress, possibly at a later call.
+     *
+     * The first page, which holds the standard descriptors, is
+     * never given back.
+     */
+    size_t
+    file_descriptors_manager::shrink (void)
+    {
+      if (shrinking__.test_and_set (std::memory_order_acquire))
+        {
+          // Another thread is already shrinking.
+          return 0;
+        }
+
+      std::size_t released = 0;
+      for (std::size_t p = pages_count__; p-- > 1;)
+        {
+          page* pg = pages__[p].load (std::memory_order_acquire);
+          if (pg == nullptr)
+            {
+              continue;
+            }
+
+          bitmap_word_t expected = initial_bits (p);
+          if (!pg->used.compare_exchange_strong (
+                  expected, ~static_cast<bitmap_word_t> (0),
+                  std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+              // Still in use.
+              break;
+            }
+
+          // Sequentially consistent with the lookups counter, so
+          // free_retired() sees any lookup which loaded the page.
+          pages__[p].store (nullptr);
+          mapped_pages__.fetch_sub (1, std::memory_order_relaxed);
+
+          pg->retired_next = retired__;
+          retired__ = pg;
+          released += slots_per_page__;
+        }
+
+      free_retired ();
+
+      shrinking__.clear (std::memory_order_release);
+
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
+      trace::printf ("file_descriptors_manager::%s() %u\n", __func__,
+                     released);
+#endif
+      return released;
+    }
+
     socket*
     file_descriptors_manager::socket (int fildes)
     {
-      assert ((fildes >= 0) && (static_cast<std::size_t> (fildes) < size__));
-      auto* const io = descriptors_array__[fildes];
-      if (io->get_type () != io::type::socket)
+      auto* const io = file_descriptors_manager::io (fildes);
+      if ((io == nullptr) || (io->get_type () != io::type::socket))
         {
           return nullptr;
         }
@@ -197,16 +531,367 @@ namespace micro_os_plus
     size_t
     file_descriptors_manager::used (void)
     {
-      std::size_t count = reserved__;
-      for (std::size_t i = reserved__; i < file_descriptors_manager::size ();
-           ++i)
+      // The reserved descriptors are always counted.
+      return used__.load (std::memory_order_relaxed);
+    }
+
+    size_t
+    file_descriptors_manager::used (io::type_t type)
+    {
+      if (type == 0)
+        {
+          return 0;
+        }
+      return type_used__[__builtin_ctz (type)].load (
+          std::memory_order_relaxed);
+    }
+
+    /**
+     * @details
+     * The io must have been removed from the table before. Once no
+     * lookup is in progress, no thread can pin it any more, so a
+     * zero pin count is final.
+     */
+    bool
+    file_descriptors_manager::is_reclaimable (class io* io)
+    {
+      if (is_lookup_in_progress ())
+        {
+          return false;
+        }
+      return io->pins_.load (std::memory_order_acquire) == 0;
+    }
+
+    void
+    file_descriptors_manager::count (class io* io, int delta)
+    {
+      io::type_t type = io->get_type ();
+      while (type != 0)
+        {
+          std::size_t bit = static_cast<std::size_t> (__builtin_ctz (type));
+          type_used__[bit].fetch_add (static_cast<std::size_t> (delta),
+                                      std::memory_order_relaxed);
+          type &= type - 1;
+        }
+    }
+
+    file_descriptors_manager::bitmap_word_t
+    file_descriptors_manager::initial_bits (std::size_t p)
+    {
+      bitmap_word_t bits = 0;
+
+      // Never allocate the standard descriptors.
+      if (p == 0)
+        {
+          bits |= (static_cast<bitmap_word_t> (1) << reserved__) - 1;
+        }
+
+      // Mark the bits past the end of the table as used.
+      std::size_t end = (p + 1) * slots_per_page__;
+      if (end > size__)
+        {
+          bits |= ~((static_cast<bitmap_word_t> (1)
+                     << (slots_per_page__ - (end - size__)))
+                    - 1);
+        }
+      return bits;
+    }
+
+    /**
+     * @details
+     * The pages are scanned in order, and a missing page is mapped
+     * when reached, so the lowest free descriptor is returned, as
+     * required by POSIX. -1 is returned only when all pages up to
+     * the maximum size are full.
+     */
+    int
+    file_descriptors_manager::claim (class io* io)
+    {
+      for (std::size_t p = 0; p < pages_count__; ++p)
+        {
+          lookups__[p].fetch_add (1);
+          page* pg = pages__[p].load ();
+          if (pg == nullptr)
+            {
+              pg = map_page (p);
+            }
+
+          bitmap_word_t word = pg->used.load (std::memory_order_relaxed);
+          while (~word != 0)
+            {
+              bitmap_word_t bit = ~word & (word + 1);
+              // On failure, word is reloaded; retry in the same page.
+              if (!pg->used.compare_exchange_weak (word, word | bit,
+                                                   std::memory_order_acquire,
+                                                   std::memory_order_relaxed))
+                {
+                  continue;
+                }
+
+              std::size_t j = static_cast<std::size_t> (__builtin_ctzl (bit));
+
+              pg->slots[j].store (io, std::memory_order_release);
+              lookups__[p].fetch_sub (1);
+
+              used__.fetch_add (1, std::memory_order_relaxed);
+              count (io, 1);
+              return static_cast<int> (p * slots_per_page__ + j);
+            }
+          lookups__[p].fetch_sub (1);
+        }
+
+      return -1;
+    }
+
+    /**
+     * @details
+     * Store the io in the given slot, used or not, and return the
+     * previous one. A slot with the bit set but no io is either
+     * being published by claim(), being released, or in a page
+     * retired by shrink(); all are short, so retry.
+     */
+    io*
+    file_descriptors_manager::place (std::size_t i, class io* io)
+    {
+      std::size_t p = i / slots_per_page__;
+      std::size_t j = i % slots_per_page__;
+      bitmap_word_t bit = static_cast<bitmap_word_t> (1) << j;
+
+      class io* old_io = nullptr;
+
+      lookups__[p].fetch_add (1);
+      for (;;)
+        {
+          page* pg = pages__[p].load ();
+          if (pg == nullptr)
+            {
+              pg = map_page (p);
+            }
+
+          bitmap_word_t word
+              = pg->used.fetch_or (bit, std::memory_order_acquire);
+          if ((word & bit) == 0)
+            {
+              // It was free and now it is ours.
+              pg->slots[j].store (io, std::memory_order_release);
+              used__.fetch_add (1, std::memory_order_relaxed);
+              break;
+            }
+
+          old_io = pg->slots[j].load (std::memory_order_acquire);
+          if ((old_io == nullptr) && (i >= reserved__))
+            {
+              continue;
+            }
+
+          if (pg->slots[j].compare_exchange_strong (
+                  old_io, io, std::memory_order_acq_rel,
+                  std::memory_order_relaxed))
+            {
+              break;
+            }
+        }
+      lookups__[p].fetch_sub (1);
+
+      return old_io;
+    }
+
+    /**
+     * @details
+     * Clear the slot if it refers to the given io (or to any io, if
+     * nullptr) and return the number of descriptors still referring
+     * to it, or -1 if the slot was not used.
+     */
+    int
+    file_descriptors_manager::release (std::size_t i, class io* io)
+    {
+      std::size_t p = i / slots_per_page__;
+      std::size_t j = i % slots_per_page__;
+
+      lookups__[p].fetch_add (1);
+      page* pg = pages__[p].load ();
+      class io* old_io = nullptr;
+      if (pg != nullptr)
+        {
+          if (io == nullptr)
+            {
+              old_io = pg->slots[j].exchange (nullptr,
+                                              std::memory_order_acq_rel);
+            }
+          else if (pg->slots[j].compare_exchange_strong (
+                       io, nullptr, std::memory_order_acq_rel,
+                       std::memory_order_relaxed))
+            {
+              old_io = io;
+            }
+        }
+      lookups__[p].fetch_sub (1);
+
+      if (old_io == nullptr)
+        {
+          return -1;
+        }
+
+      // A page with a bit set is never given back, so it is safe
+      // to access it until the bit is released.
+      if (i >= reserved__)
+        {
+          pg->used.fetch_and (~(static_cast<bitmap_word_t> (1) << j),
+                              std::memory_order_release);
+          used__.fetch_sub (1, std::memory_order_relaxed);
+        }
+
+      return drop (old_io, i);
+    }
+
+    int
+    file_descriptors_manager::drop (class io* io, std::size_t i)
+    {
+      count (io, -1);
+
+      unsigned int remaining
+          = io->descriptors_.fetch_sub (1, std::memory_order_acq_rel) - 1;
+      if (remaining == 0)
+        {
+          io->clear_file_descriptor ();
+        }
+      else if (io->file_descriptor () == static_cast<int> (i))
+        {
+          // Keep a valid descriptor in the io.
+          io->file_descriptor (find (io));
+        }
+      return static_cast<int> (remaining);
+    }
+
+    /**
+     * @details
+     * Increment the descriptors count, unless it is already zero,
+     * i.e. all descriptors were closed and the io is closing.
+     */
+    bool
+    file_descriptors_manager::retain (class io* io)
+    {
+      unsigned int n = io->descriptors_.load (std::memory_order_relaxed);
+      do
+        {
+          if (n == 0)
+            {
+              return false;
+            }
+        }
+      while (!io->descriptors_.compare_exchange_weak (
+          n, n + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+      return true;
+    }
+
+    int
+    file_descriptors_manager::find (class io* io)
+    {
+      int fd = -1;
+
+      for (std::size_t p = 0; (p < pages_count__) && (fd < 0); ++p)
+        {
+          lookups__[p].fetch_add (1);
+          page* pg = pages__[p].load ();
+          if (pg != nullptr)
+            {
+              for (std::size_t j = 0; j < slots_per_page__; ++j)
+                {
+                  if (pg->slots[j].load (std::memory_order_acquire) == io)
+                    {
+                      fd = static_cast<int> (p * slots_per_page__ + j);
+                      break;
+                    }
+                }
+            }
+          lookups__[p].fetch_sub (1);
+        }
+
+      return fd;
+    }
+
+    /**
+     * @details
+     * Several threads may race to map the same page; only one
+     * pointer is published, the others are discarded.
+     */
+    file_descriptors_manager::page*
+    file_descriptors_manager::map_page (std::size_t p)
+    {
+      page* pg = new page;
+      pg->used.store (initial_bits (p), std::memory_order_relaxed);
+      for (std::size_t j = 0; j < slots_per_page__; ++j)
+        {
+          pg->slots[j].store (nullptr, std::memory_order_relaxed);
+        }
+      pg->retired_next = nullptr;
+      pg->number = p;
+
+      page* expected = nullptr;
+      if (!pages__[p].compare_exchange_strong (expected, pg,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+        {
+          delete pg;
+          return expected;
+        }
+
+      mapped_pages__.fetch_add (1, std::memory_order_relaxed);
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_FILE_DESCRIPTORS_MANAGER)
+      trace::printf ("file_descriptors_manager::%s(%u)\n", __func__, p);
+#endif
+      return pg;
+    }
+
+    /**
+     * @details
+     * A retired page is freed when no lookup is in progress on its
+     * index; the others are kept, and retried at the next shrink().
+     */
+    void
+    file_descriptors_manager::free_retired (void)
+    {
+      page** link = &retired__;
+      while (*link != nullptr)
+        {
+          page* pg = *link;
+          if (lookups__[pg->number].load () != 0)
+            {
+              link = &pg->retired_next;
+              continue;
+            }
+          *link = pg->retired_next;
+          delete pg;
+        }
+    }
+
+    io*
+    file_descriptors_manager::load (std::size_t i)
+    {
+      page* pg = pages__[i / slots_per_page__].load ();
+      if (pg == nullptr)
+        {
+          return nullptr;
+        }
+      return pg->slots[i % slots_per_page__].load (std::memory_order_acquire);
+    }
+
+    /**
+     * @details
+     * The io may have been in any page, so all counters are
+     * checked; this is done only when reclaiming a closed io.
+     */
+    bool
+    file_descriptors_manager::is_lookup_in_progress (void)
+    {
+      for (std::size_t p = 0; p < pages_count__; ++p)
         {
-          if (descriptors_array__[i] != nullptr)
+          if (lookups__[p].load () != 0)
             {
-              ++count;
+              return true;
             }
         }
-      return count;
+      return false;
     }
 
     // ========================================================================
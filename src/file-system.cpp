@@ -28,6 +28,7 @@
 #include <micro-os-plus/posix-io/file-system.h>
 #include <micro-os-plus/posix-io/block-device.h>
 #include <micro-os-plus/posix-io/device-registry.h>
+#include <micro-os-plus/posix-io/rcu.h>
 
 #include <cerrno>
 #include <cassert>
@@ -68,12 +69,23 @@ namespace micro_os_plus
 
 #pragma GCC diagnostic pop
 
-    file_system* file_system::mounted_root__;
+    // Initialised to 0 by BSS.
+    std::atomic<file_system*> file_system::mounted_root__;
+
+    std::atomic<file_system::mount_node*> file_system::mount_nodes__;
 
     /**
      * @endcond
      */
 
+    // ------------------------------------------------------------------------
+
+    __attribute__ ((weak)) const static_name_view<file_system>*
+    static_mount_table (void)
+    {
+      return nullptr;
+    }
+
     // ------------------------------------------------------------------------
     int
     mkdir (const char* path, mode_t mode)
@@ -94,6 +106,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       auto adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -126,6 +141,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       auto adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -146,18 +164,26 @@ namespace micro_os_plus
       trace::printf ("%s()\n", __func__);
 #endif
 
+      {
+        // Mounts and unmounts wait until the walk is done.
+        rcu::write_guard wg;
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Waggregate-return"
-      // Enumerate all mounted file systems and sync them.
-      for (auto&& fs : file_system::mounted_list__)
-        {
-          fs.sync ();
-        }
+        // Enumerate all mounted file systems and sync them.
+        for (auto&& fs : file_system::mounted_list__)
+          {
+            fs.sync ();
+          }
 #pragma GCC diagnostic pop
+      }
 
-      if (file_system::mounted_root__ != nullptr)
+      rcu::read_guard rg;
+
+      auto* const root = file_system::mounted_root__.load ();
+      if (root != nullptr)
         {
-          file_system::mounted_root__->sync ();
+          root->sync ();
         }
     }
 
@@ -184,6 +210,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       const char* adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -215,6 +244,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       const char* adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -246,6 +278,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       const char* adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -283,6 +318,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       auto adjusted_existing = existing;
       auto adjusted_new = _new;
       auto* const fs
@@ -294,6 +332,13 @@ namespace micro_os_plus
           return -1;
         }
 
+      if (adjusted_new == nullptr)
+        {
+          // Cannot rename across file systems.
+          errno = EXDEV;
+          return -1;
+        }
+
       return fs->rename (adjusted_existing, adjusted_new);
     }
 
@@ -316,6 +361,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       auto adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -347,6 +395,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       auto adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -378,6 +429,9 @@ namespace micro_os_plus
           return -1;
         }
 
+      // Keep the file system mounted until the call returns.
+      rcu::read_guard rg;
+
       auto adjusted_path = path;
       auto* const fs = file_system::identify_mounted (&adjusted_path);
 
@@ -413,6 +467,9 @@ namespace micro_os_plus
 
       posix::directory* dir;
 
+      // The file system must not go away before opendir() returns.
+      rcu::read_guard rg;
+
       while (true)
         {
           // Check if path is a device.
@@ -542,23 +599,23 @@ namespace micro_os_plus
           return -1;
         }
 
+#if !defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
       if (path != nullptr)
         {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Waggregate-return"
-          for (auto&& fs : mounted_list__)
+          rcu::write_guard wg;
+
+          // Validate the path by checking duplicates; "/a" and "/a/"
+          // are the same mount point.
+          auto* const node = find_mount_node (path, false);
+          if ((node != nullptr) && (node->fs.load () != nullptr))
             {
-              // Validate the device name by checking duplicates.
-              if (std::strcmp (path, fs.mounted_path_) == 0)
-                {
-                  trace::printf ("Path \"%s\" already mounted.", path);
+              trace::printf ("Path \"%s\" already mounted.", path);
 
-                  errno = EBUSY;
-                  return -1;
-                }
+              errno = EBUSY;
+              return -1;
             }
-#pragma GCC diagnostic pop
         }
+#endif
 
       char* p = const_cast<char*> (path);
       if (p != nullptr)
@@ -579,13 +636,23 @@ namespace micro_os_plus
 
       if (p == nullptr)
         {
-          mounted_root__ = this;
           mounted_path_ = "/";
+          mounted_root__.store (this, std::memory_order_release);
         }
       else
         {
+          rcu::write_guard wg;
+
           mounted_list__.link (*this);
           mounted_path_ = path;
+#if !defined(MICRO_OS_PLUS_POSIX_IO_STATIC_REGISTRIES)
+          mount_node_ = find_mount_node (path, true);
+          if (mount_node_ != nullptr)
+            {
+              // Published last, when the file system is usable.
+              mount_node_->fs.store (this, std::memory_order_release);
+            }
+#endif
         }
 
       return 0;
@@ -603,19 +670,36 @@ namespace micro_os_plus
       trace::printf ("file_system::%s(%u) @%p\n", __func__, flags, this);
 #endif
 
-      mount_manager_links_.unlink ();
-      mounted_path_ = nullptr;
-
-      if (this == mounted_root__)
+      if (this == mounted_root__.load ())
         {
+          rcu::write_guard wg;
+
           if (!mounted_list__.empty ())
             {
               errno = EBUSY;
               return -1;
             }
 
-          mounted_root__ = nullptr;
+          mounted_root__.store (nullptr, std::memory_order_release);
+          // Wait for the readers which may still use the root file
+          // system, before it is unmounted.
+          rcu::synchronize ();
+        }
+      else
+        {
+          rcu::write_guard wg;
+
+          mount_manager_links_.unlink ();
+          if (mount_node_ != nullptr)
+            {
+              mount_node_->fs.store (nullptr, std::memory_order_release);
+              // Also waits for the readers which may still use this
+              // file system, before it is unmounted.
+              prune_mount_node (mount_node_);
+              mount_node_ = nullptr;
+            }
         }
+      mounted_path_ = nullptr;
 
       if (!device ().is_opened ())
         {
@@ -628,50 +712,260 @@ namespace micro_os_plus
       return ret;
     }
 
+    /**
+     * @details
+     * The mount points are kept in a trie of path components, so
+     * the lookup walks the path once, whatever the number of mount
+     * points, and the longest mount path wins when they nest
+     * (like `/data/` and `/data/logs/`).
+     */
     file_system*
     file_system::identify_mounted (const char** path1, const char** path2)
     {
       assert (path1 != nullptr);
       assert (*path1 != nullptr);
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Waggregate-return"
-      for (auto&& fs : mounted_list__)
+      auto* fs = match_mounted (path1);
+      if (fs == nullptr)
         {
-          auto len = std::strlen (fs.mounted_path_);
+          // If root file system defined, return it.
+          fs = mounted_root__.load (std::memory_order_acquire);
+        }
 
-          // Check if path1 starts with the mounted path.
-          if (std::strncmp (fs.mounted_path_, *path1, len) == 0)
+      if ((fs != nullptr) && (path2 != nullptr) && (*path2 != nullptr))
+        {
+          auto* fs2 = match_mounted (path2);
+          if (fs2 == nullptr)
             {
-              // If so, adjust paths to skip over prefix, but keep '/'.
-              *path1 = (*path1 + len - 1);
-              while ((*path1)[1] == '/')
-                {
-                  *path1 = (*path1 + 1);
-                }
+              fs2 = mounted_root__.load (std::memory_order_acquire);
+            }
+          if (fs2 != fs)
+            {
+              // Different file systems.
+              *path2 = nullptr;
+            }
+        }
+
+      // Null if not found.
+      return fs;
+    }
+
+    /**
+     * @details
+     * Only components followed by a `/` are matched, so a mount
+     * path `/data/` matches `/data/` and `/data/file`, but not
+     * `/data` or `/database`.
+     * If matched, the path is adjusted to skip over the prefix, but
+     * keep the `/`.
+     *
+     * The static mount table is checked first, with the path as is,
+     * then the mount trie; the deeper match wins.
+     */
+    file_system*
+    file_system::match_mounted (const char** path)
+    {
+      const char* p = *path;
+      if (*p != '/')
+        {
+          return nullptr;
+        }
 
-              if ((path2 != nullptr) && (*path2 != nullptr))
+      file_system* fs = nullptr;
+      const char* adjusted = nullptr;
+
+      auto* const table = static_mount_table ();
+      if (table != nullptr)
+        {
+          // A single pass, hashing the path incrementally and
+          // probing the table at each '/'.
+          using view = static_name_view<file_system>;
+          auto h = view::hash_start (table->seed);
+          for (const char* c = p; *c != '\0'; ++c)
+            {
+              h = view::hash_step (h, *c);
+              if (*c == '/')
                 {
-                  *path2 = (*path2 + len - 1);
-                  while ((*path2)[1] == '/')
+                  auto* const f = table->find (
+                      h, p, static_cast<std::size_t> (c - p + 1));
+                  if ((f != nullptr) && (f->mounted_path_ != nullptr))
                     {
-                      *path2 = (*path2 + 1);
+                      fs = f;
+                      adjusted = c;
                     }
                 }
+            }
+        }
+
+      // Lock-free; the nodes stay valid until the guard is released,
+      // even if concurrently unmounted.
+      rcu::read_guard rg;
 
-              return &fs;
+      auto* list = mount_nodes__.load (std::memory_order_acquire);
+      while (list != nullptr)
+        {
+          while (*p == '/')
+            {
+              ++p;
+            }
+          const char* end = p;
+          while ((*end != '\0') && (*end != '/'))
+            {
+              ++end;
+            }
+          if (*end != '/')
+            {
+              break;
+            }
+
+          auto length = static_cast<std::size_t> (end - p);
+          auto* node = list;
+          while ((node != nullptr)
+                 && ((node->length != length)
+                     || (std::strncmp (node->name, p, length) != 0)))
+            {
+              node = node->next.load (std::memory_order_acquire);
             }
+          if (node == nullptr)
+            {
+              break;
+            }
+
+          // Deeper than the static match, if any.
+          auto* const f = node->fs.load (std::memory_order_acquire);
+          if ((f != nullptr) && ((adjusted == nullptr) || (end > adjusted)))
+            {
+              fs = f;
+              adjusted = end;
+            }
+
+          list = node->children.load (std::memory_order_acquire);
+          p = end;
         }
-#pragma GCC diagnostic pop
 
-      // If root file system defined, return it.
-      if (mounted_root__ != nullptr)
+      if (fs != nullptr)
         {
-          return mounted_root__;
+          while (adjusted[1] == '/')
+            {
+              ++adjusted;
+            }
+          *path = adjusted;
         }
+      return fs;
+    }
 
-      // Not found.
-      return nullptr;
+    /**
+     * @details
+     * Return the node of the last component of the path, possibly
+     * creating it and the nodes above it, or nullptr if the path
+     * has no components.
+     *
+     * Must be called with the `rcu::write_guard` held; new nodes
+     * are fully initialised before being published.
+     */
+    file_system::mount_node*
+    file_system::find_mount_node (const char* path, bool create)
+    {
+      mount_node* parent = nullptr;
+      std::atomic<mount_node*>* list = &mount_nodes__;
+      mount_node* node = nullptr;
+
+      const char* p = path;
+      while (true)
+        {
+          while (*p == '/')
+            {
+              ++p;
+            }
+          if (*p == '\0')
+            {
+              break;
+            }
+          const char* name = p;
+          while ((*p != '\0') && (*p != '/'))
+            {
+              ++p;
+            }
+          auto length = static_cast<std::size_t> (p - name);
+
+          node = list->load ();
+          while ((node != nullptr)
+                 && ((node->length != length)
+                     || (std::strncmp (node->name, name, length) != 0)))
+            {
+              node = node->next.load ();
+            }
+
+          if (node == nullptr)
+            {
+              if (!create)
+                {
+                  return nullptr;
+                }
+
+              // The name is copied, since the path of the file system
+              // which created the node may be unmounted before the
+              // deeper mount points.
+              node = new mount_node;
+              node->name = new char[length + 1];
+              std::memcpy (node->name, name, length);
+              node->name[length] = '\0';
+              node->length = length;
+              node->fs.store (nullptr);
+              node->parent = parent;
+              node->children.store (nullptr);
+              node->next.store (list->load ());
+              list->store (node, std::memory_order_release);
+            }
+
+          parent = node;
+          list = &node->children;
+        }
+
+      return node;
+    }
+
+    /**
+     * @details
+     * Remove the node and its parents, as long as they have neither
+     * a file system mounted nor children.
+     *
+     * Must be called with the `rcu::write_guard` held. The removed
+     * nodes keep their links, so readers already on them can
+     * continue; they are deleted after the grace period.
+     */
+    void
+    file_system::prune_mount_node (mount_node* node)
+    {
+      mount_node* retired = nullptr;
+      while ((node != nullptr) && (node->fs.load () == nullptr)
+             && (node->children.load () == nullptr))
+        {
+          auto* const parent = node->parent;
+          std::atomic<mount_node*>* link
+              = (parent != nullptr) ? &parent->children : &mount_nodes__;
+          while (link->load () != node)
+            {
+              link = &link->load ()->next;
+            }
+          link->store (node->next.load (), std::memory_order_release);
+
+          // The parent link is no longer needed, reuse it to chain
+          // the retired nodes.
+          node->parent = retired;
+          retired = node;
+
+          node = parent;
+        }
+
+      rcu::synchronize ();
+
+      while (retired != nullptr)
+        {
+          auto* const next = retired->parent;
+          delete[] retired->name;
+          delete retired;
+          retired = next;
+        }
     }
 
     // ------------------------------------------------------------------------
@@ -27,6 +27,7 @@
 
 #include <micro-os-plus/posix-io/file.h>
 #include <micro-os-plus/posix-io/file-system.h>
+#include <micro-os-plus/posix/sys/uio.h>
 
 #include <micro-os-plus/diag/trace.h>
 
@@ -162,6 +163,141 @@ namespace micro_os_plus
       return -1;
     }
 
+    /**
+     * @details
+     * Small scattered vectors are gathered in a stack buffer;
+     * otherwise buffers adjacent in memory are merged and passed
+     * to the file system as a single `do_read()`, which allows it
+     * to transfer whole clusters directly, without the sector cache.
+     */
+    ssize_t
+    file_impl::do_readv (const iovec* iov, int iovcnt)
+    {
+      std::size_t nbyte = bounce_iovecs (iov, iovcnt);
+      if (nbyte > 0)
+        {
+          return bounce_readv (iov, iovcnt, nbyte);
+        }
+
+      ssize_t total = 0;
+      ssize_t ret = 0;
+      while (iovcnt > 0)
+        {
+          int cnt = contiguous_iovecs (iov, iovcnt, &nbyte);
+
+          ret = do_read (iov->iov_base, nbyte);
+          if (ret < 0)
+            {
+              break;
+            }
+          // do_read() uses the current offset, advance it.
+          offset_ += ret;
+          total += ret;
+          if (static_cast<std::size_t> (ret) < nbyte)
+            {
+              break; // End of file.
+            }
+
+          iov += cnt;
+          iovcnt -= cnt;
+        }
+
+      // The offset is updated by the caller.
+      offset_ -= total;
+      return (ret < 0 && total == 0) ? ret : total;
+    }
+
+    ssize_t
+    file_impl::do_writev (const iovec* iov, int iovcnt)
+    {
+      std::size_t nbyte = bounce_iovecs (iov, iovcnt);
+      if (nbyte > 0)
+        {
+          return bounce_writev (iov, iovcnt, nbyte);
+        }
+
+      ssize_t total = 0;
+      ssize_t ret = 0;
+      while (iovcnt > 0)
+        {
+          int cnt = contiguous_iovecs (iov, iovcnt, &nbyte);
+
+          ret = do_write (iov->iov_base, nbyte);
+          if (ret < 0)
+            {
+              break;
+            }
+          // do_write() uses the current offset, advance it.
+          offset_ += ret;
+          total += ret;
+          if (static_cast<std::size_t> (ret) < nbyte)
+            {
+              break; // Device full.
+            }
+
+          iov += cnt;
+          iovcnt -= cnt;
+        }
+
+      // The offset is updated by the caller.
+      offset_ -= total;
+      return (ret < 0 && total == 0) ? ret : total;
+    }
+
+    /**
+     * @details
+     * Generic fallback, built on `do_lseek()` and `do_read()`, which
+     * saves and restores the current offset. It is atomic only when
+     * called via a `file_lockable`; file systems able to read at
+     * a given position should override it.
+     */
+    ssize_t
+    file_impl::do_pread (void* buf, std::size_t nbyte, off_t offset)
+    {
+      off_t saved = do_lseek (0, SEEK_CUR);
+      if (saved < 0)
+        {
+          return -1;
+        }
+
+      if (do_lseek (offset, SEEK_SET) < 0)
+        {
+          return -1;
+        }
+
+      ssize_t ret = do_read (buf, nbyte);
+
+      // Restore the offset, but preserve the read errno, if any.
+      int err = errno;
+      do_lseek (saved, SEEK_SET);
+      errno = err;
+
+      return ret;
+    }
+
+    ssize_t
+    file_impl::do_pwrite (const void* buf, std::size_t nbyte, off_t offset)
+    {
+      off_t saved = do_lseek (0, SEEK_CUR);
+      if (saved < 0)
+        {
+          return -1;
+        }
+
+      if (do_lseek (offset, SEEK_SET) < 0)
+        {
+          return -1;
+        }
+
+      ssize_t ret = do_write (buf, nbyte);
+
+      int err = errno;
+      do_lseek (saved, SEEK_SET);
+      errno = err;
+
+      return ret;
+    }
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus
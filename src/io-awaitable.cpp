@@ -0,0 +1,267 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/io.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cpp_impl_coroutine)
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#endif
+
+      using ready_list
+          = utils::intrusive_list<io_awaitable, utils::double_list_links,
+                                  &io_awaitable::ready_links_>;
+
+      // Awaitables whose descriptors were notified, in order.
+      ready_list ready_list__;
+
+      // The scheduler threads sleep here.
+      io_waiter ready_waiter__;
+
+#pragma GCC diagnostic pop
+    } // namespace
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    io_awaitable::io_awaitable (class io& io, io::events_t events)
+        : io_ (io), //
+          events_ (events | io::event::error | io::event::hangup)
+    {
+    }
+
+    io_awaitable::~io_awaitable ()
+    {
+      io_.impl ().unsubscribe (*this);
+
+      io_waiter::critical_section cs;
+
+      if (ready_links_.linked ())
+        {
+          ready_links_.unlink ();
+        }
+    }
+
+    bool
+    io_awaitable::await_ready (void)
+    {
+      return (io_.poll_events () & events_) != 0;
+    }
+
+    /**
+     * @details
+     * Subscribe first, then check again, so a notification which
+     * arrives in between is not lost; if the io became ready,
+     * do not suspend at all.
+     *
+     * Such a notification may have already queued the awaitable;
+     * unless a scheduler thread took it from the queue, and will
+     * resume it, it is removed from the queue and claimed, so it
+     * is not resumed twice.
+     */
+    bool
+    io_awaitable::await_suspend (std::coroutine_handle<> handle)
+    {
+      handle_ = handle;
+      is_claimed_ = false;
+
+      io_.impl ().subscribe (*this);
+
+      if ((io_.poll_events () & events_) != 0)
+        {
+          {
+            io_waiter::critical_section cs;
+
+            if (is_claimed_)
+              {
+                // Already taken by run_ready(), which resumes it.
+                return true;
+              }
+            is_claimed_ = true;
+
+            if (ready_links_.linked ())
+              {
+                ready_links_.unlink ();
+              }
+          }
+
+          io_.impl ().unsubscribe (*this);
+          return false;
+        }
+
+      return true;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    void
+    io_awaitable::notify (io_impl& impl, io::events_t events)
+    {
+      if ((events & events_) != 0)
+        {
+          enqueue ();
+        }
+    }
+
+    void
+    io_awaitable::detach (io_impl& impl)
+    {
+      // The io was closed; resume, the transfer will fail with EBADF.
+      is_detached_ = true;
+      enqueue ();
+    }
+
+#pragma GCC diagnostic pop
+
+    void
+    io_awaitable::enqueue (void)
+    {
+      io_waiter::critical_section cs;
+
+      if (is_claimed_)
+        {
+          return; // Being resumed.
+        }
+
+      if (!ready_links_.linked ())
+        {
+          ready_list__.link (*this);
+        }
+      ready_waiter__.wakeup ();
+    }
+
+    /**
+     * @details
+     * The readiness is checked again before resuming; if the
+     * notification was stale, the awaitable remains subscribed
+     * and waits for the next one.
+     */
+    int
+    io_awaitable::run_ready (void)
+    {
+      int count = 0;
+      while (true)
+        {
+          io_awaitable* awaitable;
+          {
+            io_waiter::critical_section cs;
+
+            if (ready_list__.empty ())
+              {
+                break;
+              }
+            awaitable = ready_list__.unlink_head ();
+            awaitable->is_claimed_ = true;
+          }
+
+          if (!awaitable->is_detached_
+              && ((awaitable->io_.poll_events () & awaitable->events_) == 0))
+            {
+              {
+                io_waiter::critical_section cs;
+
+                awaitable->is_claimed_ = false;
+              }
+
+              // A notification while claimed was dropped; check
+              // again, so it is not lost.
+              if (awaitable->is_detached_
+                  || ((awaitable->io_.poll_events () & awaitable->events_)
+                      != 0))
+                {
+                  awaitable->enqueue ();
+                }
+              continue;
+            }
+
+          awaitable->io_.impl ().unsubscribe (*awaitable);
+          ++count;
+
+          // May destroy the awaitable, do not use it afterwards.
+          awaitable->handle_.resume ();
+        }
+
+      return count;
+    }
+
+    int
+    io_awaitable::wait_ready (timespec* timeout)
+    {
+      ready_waiter__.arm ();
+      {
+        io_waiter::critical_section cs;
+
+        if (!ready_list__.empty ())
+          {
+            return 0;
+          }
+      }
+
+      return ready_waiter__.wait (timeout);
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+#endif // defined(__cpp_impl_coroutine)
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,429 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/io-ring.h>
+#include <micro-os-plus/posix-io/device.h>
+#include <micro-os-plus/posix-io/file.h>
+#include <micro-os-plus/posix-io/file-descriptors-manager.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    void
+    io_request::complete (ssize_t result, int error)
+    {
+      ring_->post_completion (this, result, error);
+    }
+
+    // ========================================================================
+
+    io_ring::io_ring (std::size_t entries)
+        : sq_mask_ (entries - 1), //
+          cq_mask_ (2 * entries - 1)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO_RING)
+      trace::printf ("io_ring::%s(%u)=@%p\n", __func__, entries, this);
+#endif
+
+      // Must be a power of 2.
+      assert ((entries > 0) && ((entries & (entries - 1)) == 0));
+
+      sq_array_ = new submission[entries];
+      cq_array_ = new completion[2 * entries];
+      requests_array_ = new io_request[entries];
+
+      for (std::size_t i = 0; i < entries; ++i)
+        {
+          requests_array_[i].ring_ = this;
+          free_list_.link (requests_array_[i]);
+        }
+    }
+
+    io_ring::~io_ring ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO_RING)
+      trace::printf ("io_ring::%s() @%p\n", __func__, this);
+#endif
+
+      // Requests still in flight would complete into freed memory.
+      assert (in_flight_ == 0);
+
+      delete[] requests_array_;
+      delete[] cq_array_;
+      delete[] sq_array_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    io_ring::submission*
+    io_ring::get_submission (void)
+    {
+      if (sq_tail_local_ - sq_head_ > sq_mask_)
+        {
+          return nullptr; // Full.
+        }
+
+      submission* sqe = &sq_array_[sq_tail_local_ & sq_mask_];
+      ++sq_tail_local_;
+
+      sqe->op = opcode::nop;
+      sqe->fildes = -1;
+      sqe->buf = nullptr;
+      sqe->nbyte = 0;
+      sqe->offset = -1;
+      sqe->user_data = nullptr;
+
+      return sqe;
+    }
+
+    int
+    io_ring::submit (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO_RING)
+      trace::printf ("io_ring::%s() @%p\n", __func__, this);
+#endif
+
+      int count;
+      {
+        io_waiter::critical_section cs;
+
+        count = static_cast<int> (sq_tail_local_ - sq_tail_);
+        sq_tail_ = sq_tail_local_;
+      }
+
+      if (count > 0)
+        {
+          sq_waiter_.wakeup ();
+        }
+      return count;
+    }
+
+    int
+    io_ring::wait_completions (std::size_t min_complete, timespec* timeout)
+    {
+      if (min_complete > cq_mask_ + 1)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      errno = 0;
+
+      while (true)
+        {
+          // A completion after this point makes wait() return at once.
+          cq_waiter_.arm ();
+
+          std::size_t available = cq_tail_ - cq_head_;
+          if (available >= min_complete)
+            {
+              return static_cast<int> (available);
+            }
+
+          // Without a worker, do its job inline.
+          if (!is_running_ && (process () > 0))
+            {
+              continue;
+            }
+
+          if ((timeout != nullptr) && (timeout->tv_sec == 0)
+              && (timeout->tv_nsec == 0))
+            {
+              return static_cast<int> (available);
+            }
+
+          if (cq_waiter_.wait (timeout) < 0)
+            {
+              if (errno == ETIMEDOUT)
+                {
+                  errno = 0;
+                  return static_cast<int> (cq_tail_ - cq_head_);
+                }
+              return -1;
+            }
+        }
+    }
+
+    io_ring::completion*
+    io_ring::peek_completion (void)
+    {
+      if (cq_head_ == cq_tail_)
+        {
+          return nullptr;
+        }
+      return &cq_array_[cq_head_ & cq_mask_];
+    }
+
+    void
+    io_ring::advance_completion (void)
+    {
+      {
+        io_waiter::critical_section cs;
+
+        assert (cq_head_ != cq_tail_);
+        ++cq_head_;
+      }
+
+      // Room was made; the worker may be waiting for it.
+      sq_waiter_.wakeup ();
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * Each request in flight is guaranteed a slot in the completion
+     * ring, so it can be posted from an interrupt without further
+     * checks; the worker stops consuming when this cannot be
+     * guaranteed, until the application reaps some completions.
+     */
+    int
+    io_ring::process (void)
+    {
+      int count = 0;
+      while (true)
+        {
+          io_request* request;
+          submission* sqe;
+          {
+            io_waiter::critical_section cs;
+
+            if (sq_head_ == sq_tail_)
+              {
+                break; // Empty.
+              }
+
+            if (free_list_.empty ()
+                || ((cq_tail_ - cq_head_) + in_flight_ > cq_mask_))
+              {
+                break; // Back pressure.
+              }
+
+            request = free_list_.unlink_head ();
+            ++in_flight_;
+
+            sqe = &sq_array_[sq_head_ & sq_mask_];
+          }
+
+          request->op_ = sqe->op;
+          // Pinned until completed, a close() meanwhile does not
+          // reclaim the io under the driver.
+          request->io_ = file_descriptors_manager::pin (sqe->fildes);
+          request->buf_ = sqe->buf;
+          request->nbyte_ = sqe->nbyte;
+          request->offset_ = sqe->offset;
+          request->user_data_ = sqe->user_data;
+
+          {
+            io_waiter::critical_section cs;
+
+            // The entry was copied, release it.
+            ++sq_head_;
+          }
+
+          start (request);
+          ++count;
+        }
+
+      return count;
+    }
+
+    void
+    io_ring::run (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO_RING)
+      trace::printf ("io_ring::%s() @%p\n", __func__, this);
+#endif
+
+      is_running_ = true;
+      while (is_running_)
+        {
+          sq_waiter_.arm ();
+          if (process () == 0)
+            {
+              sq_waiter_.wait (nullptr);
+            }
+        }
+    }
+
+    void
+    io_ring::stop (void)
+    {
+      is_running_ = false;
+      sq_waiter_.wakeup ();
+    }
+
+    // ------------------------------------------------------------------------
+
+    void
+    io_ring::start (io_request* request)
+    {
+      if (request->io_ == nullptr)
+        {
+          post_completion (request, -1, EBADF);
+          return;
+        }
+
+      if (request->op_ == opcode::nop)
+        {
+          post_completion (request, 0, 0);
+          return;
+        }
+
+      errno = 0;
+      if (request->io_->impl ().do_submit (*request) == 0)
+        {
+          return; // Started; the driver will complete it.
+        }
+
+      if (errno != ENOTSUP)
+        {
+          post_completion (request, -1, errno);
+          return;
+        }
+
+      execute (request);
+    }
+
+    void
+    io_ring::execute (io_request* request)
+    {
+      auto* const io = request->io_;
+
+      errno = 0;
+      ssize_t ret;
+      switch (request->op_)
+        {
+        case opcode::read:
+          ret = (request->offset_ < 0)
+                    ? io->read (request->buf_, request->nbyte_)
+                    : io->pread (request->buf_, request->nbyte_,
+                                 request->offset_);
+          break;
+
+        case opcode::write:
+          ret = (request->offset_ < 0)
+                    ? io->write (request->buf_, request->nbyte_)
+                    : io->pwrite (request->buf_, request->nbyte_,
+                                  request->offset_);
+          break;
+
+        case opcode::readv:
+        case opcode::writev:
+          if (request->offset_ >= 0)
+            {
+              // No preadv()/pwritev() yet.
+              errno = EINVAL;
+              ret = -1;
+            }
+          else if (request->op_ == opcode::readv)
+            {
+              ret = io->readv (static_cast<const iovec*> (request->buf_),
+                               static_cast<int> (request->nbyte_));
+            }
+          else
+            {
+              ret = io->writev (static_cast<const iovec*> (request->buf_),
+                                static_cast<int> (request->nbyte_));
+            }
+          break;
+
+        case opcode::fsync:
+          if (io->get_type () & io::type::file)
+            {
+              ret = static_cast<file*> (io)->fsync ();
+            }
+          else if (io->get_type ()
+                   & (io::type::char_device | io::type::block_device))
+            {
+              static_cast<device*> (io)->sync ();
+              ret = 0;
+            }
+          else
+            {
+              errno = EINVAL;
+              ret = -1;
+            }
+          break;
+
+        default:
+          errno = EINVAL;
+          ret = -1;
+          break;
+        }
+
+      post_completion (request, ret, (ret < 0) ? errno : 0);
+    }
+
+    void
+    io_ring::post_completion (io_request* request, ssize_t result, int error)
+    {
+      if (request->io_ != nullptr)
+        {
+          file_descriptors_manager::unpin (request->io_);
+        }
+
+      {
+        io_waiter::critical_section cs;
+
+        completion* cqe = &cq_array_[cq_tail_ & cq_mask_];
+        cqe->result = result;
+        cqe->error = error;
+        cqe->user_data = request->user_data_;
+        ++cq_tail_;
+
+        request->io_ = nullptr;
+        free_list_.link (*request);
+        --in_flight_;
+      }
+
+      cq_waiter_.wakeup ();
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <micro-os-plus/diag/trace.h>
+
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#endif
+
+    io_waiter::waiters_list io_waiter::waiters_list__;
+
+#pragma GCC diagnostic pop
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    io_waiter::io_waiter (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO_WAITER)
+      trace::printf ("io_waiter::%s()=%p\n", __func__, this);
+#endif
+    }
+
+    io_waiter::~io_waiter ()
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO_WAITER)
+      trace::printf ("io_waiter::%s() @%p\n", __func__, this);
+#endif
+
+      unlink ();
+    }
+
+    void
+    io_waiter::link (void)
+    {
+      critical_section cs;
+
+      if (!waiters_links_.linked ())
+        {
+          waiters_list__.link (*this);
+        }
+    }
+
+    void
+    io_waiter::unlink (void)
+    {
+      critical_section cs;
+
+      if (waiters_links_.linked ())
+        {
+          waiters_links_.unlink ();
+        }
+    }
+
+    void
+    io_waiter::arm (void)
+    {
+      signalled_ = false;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+    /**
+     * @details
+     * The default is called with the waiters list locked, and simply
+     * wakes up the thread; derived waiters may first check
+     * if the event is of interest.
+     */
+    void
+    io_waiter::notify (io_impl& impl, io::events_t events)
+    {
+      wakeup ();
+    }
+
+#pragma GCC diagnostic pop
+
+    /**
+     * @details
+     * Broadcast to all linked waiters. The number of threads
+     * waiting for I/O in an embedded application is small, so this
+     * is preferred to keeping per descriptor lists of registrations,
+     * which would cost memory in each `io_impl`.
+     */
+    void
+    io_waiter::notify_all (io_impl& impl, io::events_t events)
+    {
+      critical_section cs;
+
+      for (auto&& waiter : waiters_list__)
+        {
+          waiter.notify (impl, events);
+        }
+    }
+
+    int
+    io_waiter::wait (timespec* timeout)
+    {
+      if (!signalled_)
+        {
+          int ret = suspend (timeout);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+      signalled_ = false;
+      return 0;
+    }
+
+    void
+    io_waiter::wakeup (void)
+    {
+      signalled_ = true;
+      resume ();
+    }
+
+    // ------------------------------------------------------------------------
+    // Default, RTOS-less implementations. To be redefined by the RTOS
+    // integration layer.
+
+    __attribute__ ((weak)) io_waiter::critical_section::critical_section (
+        void)
+    {
+    }
+
+    __attribute__ ((weak)) io_waiter::critical_section::~critical_section ()
+    {
+    }
+
+    /**
+     * @details
+     * Without a scheduler there is nothing to yield to, so
+     * return immediately and let the caller poll again. A finite
+     * timeout cannot be measured, since there is no clock
+     * either, so it expires at once.
+     *
+     * An RTOS implementation must not lose a `resume()` that occurs
+     * between checking the flag and going to sleep; a counting
+     * semaphore in `rtos_data_` does this naturally.
+     */
+    __attribute__ ((weak)) int
+    io_waiter::suspend (timespec* timeout)
+    {
+      if (timeout != nullptr)
+        {
+          timeout->tv_sec = 0;
+          timeout->tv_nsec = 0;
+
+          errno = ETIMEDOUT;
+          return -1;
+        }
+
+      return 0;
+    }
+
+    __attribute__ ((weak)) void
+    io_waiter::resume (void)
+    {
+    }
+
+    // ==========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
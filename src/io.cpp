@@ -32,12 +32,16 @@
 #include <micro-os-plus/posix-io/file-descriptors-manager.h>
 #include <micro-os-plus/posix-io/file-system.h>
 #include <micro-os-plus/posix-io/io.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+#include <micro-os-plus/posix-io/rcu.h>
 
 #include <micro-os-plus/diag/trace.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdarg>
+#include <cstring>
 
 // ----------------------------------------------------------------------------
 
@@ -102,6 +106,10 @@ namespace micro_os_plus
 
       errno = 0;
 
+      // The device or the file system must not go away before their
+      // open() returns; afterwards the open descriptor keeps them.
+      rcu::read_guard rg;
+
       posix::io* io;
       while (true)
         {
@@ -156,6 +164,189 @@ namespace micro_os_plus
       return io;
     }
 
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+      // Poll all descriptors in the given sets; store the ready
+      // ones in the output sets and return their count, or -1 if
+      // a descriptor is not valid.
+      int
+      poll_fd_sets (int nfds, const fd_set* readfds, const fd_set* writefds,
+                    const fd_set* errorfds, fd_set* rready, fd_set* wready,
+                    fd_set* eready)
+      {
+        FD_ZERO (rready);
+        FD_ZERO (wready);
+        FD_ZERO (eready);
+
+        int count = 0;
+        for (int fd = 0; fd < nfds; ++fd)
+          {
+            bool r = (readfds != nullptr) && FD_ISSET (fd, readfds);
+            bool w = (writefds != nullptr) && FD_ISSET (fd, writefds);
+            bool e = (errorfds != nullptr) && FD_ISSET (fd, errorfds);
+            if (!(r || w || e))
+              {
+                continue;
+              }
+
+            file_descriptors_manager::pinned_io pin{ fd };
+            auto* const io = pin.get ();
+            if (io == nullptr)
+              {
+                errno = EBADF;
+                return -1;
+              }
+
+            io::events_t events = io->poll_events ();
+
+            // As in POSIX, a hang up or an error make a read not block.
+            if (r
+                && (events
+                    & (io::event::readable | io::event::hangup
+                       | io::event::error)))
+              {
+                FD_SET (fd, rready);
+                ++count;
+              }
+            if (w && (events & (io::event::writable | io::event::error)))
+              {
+                FD_SET (fd, wready);
+                ++count;
+              }
+            if (e && (events & io::event::error))
+              {
+                FD_SET (fd, eready);
+                ++count;
+              }
+          }
+
+        return count;
+      }
+    } // namespace
+
+    /**
+     * @endcond
+     */
+
+    /**
+     * @details
+     * The calling thread is linked as a waiter before the first
+     * poll, so a driver notification issued between polling and
+     * going to sleep is not lost. The thread sleeps until any
+     * driver calls `io_impl::notify_events()`, then polls the
+     * descriptors again.
+     *
+     * As in Linux, the timeout is updated with the remaining time.
+     *
+     * Without an RTOS integration (the weak `io_waiter::suspend()`),
+     * nothing can sleep and there is no clock: a null timeout
+     * keeps polling the descriptors until one is ready, and a finite
+     * timeout behaves as a zero one, a single poll.
+     */
+    int
+    select (int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds,
+            timeval* timeout)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
+      trace::printf ("%s(%d)\n", __func__, nfds);
+#endif
+
+      if ((nfds < 0) || (nfds > FD_SETSIZE))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      timespec ts;
+      timespec* pts = nullptr;
+      if (timeout != nullptr)
+        {
+          if ((timeout->tv_sec < 0) || (timeout->tv_usec < 0)
+              || (timeout->tv_usec >= 1000000))
+            {
+              errno = EINVAL;
+              return -1;
+            }
+          ts.tv_sec = timeout->tv_sec;
+          ts.tv_nsec = static_cast<long> (timeout->tv_usec) * 1000;
+          pts = &ts;
+        }
+
+      errno = 0;
+
+      fd_set rready;
+      fd_set wready;
+      fd_set eready;
+
+      io_waiter waiter;
+      waiter.link ();
+
+      int ret;
+      while (true)
+        {
+          waiter.arm ();
+
+          ret = poll_fd_sets (nfds, readfds, writefds, errorfds, &rready,
+                              &wready, &eready);
+          if (ret != 0)
+            {
+              break;
+            }
+
+          if ((pts != nullptr) && (pts->tv_sec == 0) && (pts->tv_nsec == 0))
+            {
+              break; // Timeout.
+            }
+
+          if (waiter.wait (pts) < 0)
+            {
+              if (errno == ETIMEDOUT)
+                {
+                  errno = 0;
+                  ret = 0;
+                }
+              else
+                {
+                  ret = -1;
+                }
+              break;
+            }
+        }
+
+      waiter.unlink ();
+
+      if (timeout != nullptr)
+        {
+          timeout->tv_sec = ts.tv_sec;
+          timeout->tv_usec = static_cast<suseconds_t> (ts.tv_nsec / 1000);
+        }
+
+      if (ret < 0)
+        {
+          // On error the sets are not modified.
+          return ret;
+        }
+
+      if (readfds != nullptr)
+        {
+          *readfds = rready;
+        }
+      if (writefds != nullptr)
+        {
+          *writefds = wready;
+        }
+      if (errorfds != nullptr)
+        {
+          *errorfds = eready;
+        }
+
+      return ret;
+    }
+
     // ========================================================================
 
     io::io (io_impl& impl, type t)
@@ -198,9 +389,12 @@ namespace micro_os_plus
       // Execute the implementation specific code.
       int ret = impl ().do_close ();
 
-      // Remove this IO from the file descriptors registry.
-      file_descriptors_manager::deallocate (file_descriptor_);
-      file_descriptor_ = no_file_descriptor;
+      // Closing a descriptor removes it from all event pollers.
+      impl ().detach_listeners ();
+
+      // Remove this IO from the file descriptors registry, with all
+      // its duplicates.
+      file_descriptors_manager::deallocate (this);
 
       return ret;
     }
@@ -337,6 +531,48 @@ namespace micro_os_plus
       return ret;
     }
 
+    ssize_t
+    io::readv (const iovec* iov, int iovcnt)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
+      trace::printf ("io::%s(0x0%X, %d) @%p\n", __func__, iov, iovcnt, this);
+#endif
+
+      if (iov == nullptr)
+        {
+          errno = EFAULT;
+          return -1;
+        }
+
+      if (iovcnt <= 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      if (!impl ().do_is_connected ())
+        {
+          errno = EIO; // Not opened.
+          return -1;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      ssize_t ret = impl ().do_readv (iov, iovcnt);
+      if (ret >= 0)
+        {
+          impl ().offset_ += ret;
+        }
+      return ret;
+    }
+
     ssize_t
     io::writev (const iovec* iov, int iovcnt)
     {
@@ -379,6 +615,119 @@ namespace micro_os_plus
       return ret;
     }
 
+    /**
+     * @details
+     * Read from the given _offset_, without using or changing the
+     * current file offset, so concurrent readers of different regions
+     * do not need to serialise on a `lseek()` + `read()` pair.
+     */
+    ssize_t
+    io::pread (void* buf, std::size_t nbyte, off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
+      trace::printf ("io::%s(0x0%X, %u, %d) @%p\n", __func__, buf, nbyte,
+                     offset, this);
+#endif
+
+      if (buf == nullptr)
+        {
+          errno = EFAULT;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      if (!impl ().do_is_connected ())
+        {
+          errno = EIO; // Not opened.
+          return -1;
+        }
+
+      // http://pubs.opengroup.org/onlinepubs/9699919799/functions/pread.html
+      // The pread() function shall fail if the offset argument is negative.
+      if (offset < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      errno = 0;
+
+      if (nbyte == 0)
+        {
+          return 0; // Nothing to do.
+        }
+
+      // Execute the implementation specific code.
+      // The file offset is not changed.
+      ssize_t ret = impl ().do_pread (buf, nbyte, offset);
+
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
+      trace::printf ("io::%s(0x0%X, %u, %d) @%p n=%d\n", __func__, buf, nbyte,
+                     offset, this, ret);
+#endif
+      return ret;
+    }
+
+    /**
+     * @details
+     * Write at the given _offset_, without using or changing the
+     * current file offset.
+     */
+    ssize_t
+    io::pwrite (const void* buf, std::size_t nbyte, off_t offset)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
+      trace::printf ("io::%s(0x0%X, %u, %d) @%p\n", __func__, buf, nbyte,
+                     offset, this);
+#endif
+
+      if (buf == nullptr)
+        {
+          errno = EFAULT;
+          return -1;
+        }
+
+      if (!impl ().do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      if (!impl ().do_is_connected ())
+        {
+          errno = EIO; // Not opened.
+          return -1;
+        }
+
+      if (offset < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      errno = 0;
+
+      if (nbyte == 0)
+        {
+          return 0; // Nothing to do.
+        }
+
+      // Execute the implementation specific code.
+      // The file offset is not changed.
+      ssize_t ret = impl ().do_pwrite (buf, nbyte, offset);
+
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
+      trace::printf ("io::%s(0x0%X, %u, %d) @%p n=%d\n", __func__, buf, nbyte,
+                     offset, this, ret);
+#endif
+      return ret;
+    }
+
     int
     io::fcntl (int cmd, ...)
     {
@@ -490,6 +839,8 @@ namespace micro_os_plus
 #if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_IO)
       trace::printf ("io_impl::%s() @%p\n", __func__, this);
 #endif
+
+      detach_listeners ();
     }
 
     void
@@ -504,27 +855,288 @@ namespace micro_os_plus
       return true;
     }
 
+    /**
+     * @details
+     * POSIX requires regular files (and block devices) to
+     * always select true for reading and writing.
+     */
+    io::events_t
+    io_impl::do_poll_events (void)
+    {
+      return io::event::readable | io::event::writable;
+    }
+
+    void
+    io_impl::notify_events (io::events_t events)
+    {
+      pending_events_.fetch_or (events, std::memory_order_release);
+
+      {
+        io_waiter::critical_section cs;
+
+        for (auto&& listener : listeners_list_)
+          {
+            listener.notify (*this, events);
+          }
+      }
+
+      io_waiter::notify_all (*this, events);
+    }
+
+    void
+    io_impl::clear_events (io::events_t events)
+    {
+      pending_events_.fetch_and (~events, std::memory_order_release);
+    }
+
+    io::events_t
+    io_impl::pending_events (void)
+    {
+      return pending_events_.load (std::memory_order_acquire);
+    }
+
+    void
+    io_impl::subscribe (io_listener& listener)
+    {
+      io_waiter::critical_section cs;
+
+      listeners_list_.link (listener);
+    }
+
+    void
+    io_impl::unsubscribe (io_listener& listener)
+    {
+      io_waiter::critical_section cs;
+
+      if (listener.listener_links_.linked ())
+        {
+          listener.listener_links_.unlink ();
+        }
+    }
+
+    void
+    io_impl::detach_listeners (void)
+    {
+      while (true)
+        {
+          io_listener* listener;
+          {
+            io_waiter::critical_section cs;
+
+            if (listeners_list_.empty ())
+              {
+                break;
+              }
+            listener = listeners_list_.unlink_head ();
+          }
+          listener->detach (*this);
+        }
+    }
+
+    /**
+     * @details
+     * Small scattered vectors are gathered in a stack buffer and
+     * transferred with a single `do_read()`; larger ones are
+     * transferred one segment at a time.
+     */
+    ssize_t
+    io_impl::do_readv (const iovec* iov, int iovcnt)
+    {
+      std::size_t nbyte = bounce_iovecs (iov, iovcnt);
+      if (nbyte > 0)
+        {
+          return bounce_readv (iov, iovcnt, nbyte);
+        }
+
+      ssize_t total = 0;
+      ssize_t ret = 0;
+
+      const iovec* p = iov;
+      for (int i = 0; i < iovcnt; ++i, ++p)
+        {
+          ret = do_read (p->iov_base, p->iov_len);
+          if (ret < 0)
+            {
+              break;
+            }
+          // do_read() uses the current offset, advance it.
+          offset_ += ret;
+          total += ret;
+          if (static_cast<std::size_t> (ret) < p->iov_len)
+            {
+              break; // Short read, do not leave gaps.
+            }
+        }
+
+      // The offset is updated by the caller.
+      offset_ -= total;
+      return (ret < 0 && total == 0) ? ret : total;
+    }
+
     ssize_t
     io_impl::do_writev (const iovec* iov, int iovcnt)
     {
+      std::size_t nbyte = bounce_iovecs (iov, iovcnt);
+      if (nbyte > 0)
+        {
+          return bounce_writev (iov, iovcnt, nbyte);
+        }
+
       ssize_t total = 0;
+      ssize_t ret = 0;
 
       const iovec* p = iov;
       for (int i = 0; i < iovcnt; ++i, ++p)
         {
-          ssize_t ret = do_write (p->iov_base, p->iov_len);
+          ret = do_write (p->iov_base, p->iov_len);
           if (ret < 0)
             {
-              return ret;
+              break;
             }
+          // do_write() uses the current offset, advance it.
+          offset_ += ret;
           total += ret;
+          if (static_cast<std::size_t> (ret) < p->iov_len)
+            {
+              break; // Short write, do not leave gaps.
+            }
         }
-      return total;
+
+      // The offset is updated by the caller.
+      offset_ -= total;
+      return (ret < 0 && total == 0) ? ret : total;
+    }
+
+    int
+    io_impl::contiguous_iovecs (const iovec* iov, int iovcnt,
+                                std::size_t* nbyte)
+    {
+      assert (iovcnt > 0);
+
+      std::size_t len = iov[0].iov_len;
+      int i = 1;
+      for (; i < iovcnt; ++i)
+        {
+          if (static_cast<char*> (iov[i - 1].iov_base) + iov[i - 1].iov_len
+              != iov[i].iov_base)
+            {
+              break;
+            }
+          len += iov[i].iov_len;
+        }
+
+      *nbyte = len;
+      return i;
+    }
+
+    std::size_t
+    io_impl::bounce_iovecs (const iovec* iov, int iovcnt)
+    {
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE > 0
+      std::size_t nbyte;
+      if (contiguous_iovecs (iov, iovcnt, &nbyte) == iovcnt)
+        {
+          return 0; // Not scattered, no need to copy.
+        }
+
+      nbyte = 0;
+      for (int i = 0; i < iovcnt; ++i)
+        {
+          nbyte += iov[i].iov_len;
+          if (nbyte > MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE)
+            {
+              return 0;
+            }
+        }
+      return nbyte;
+#else
+      (void)iov;
+      (void)iovcnt;
+      return 0;
+#endif
+    }
+
+    ssize_t
+    io_impl::bounce_readv (const iovec* iov, int iovcnt, std::size_t nbyte)
+    {
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE > 0
+      char buf[MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE];
+      assert (nbyte <= sizeof (buf));
+
+      ssize_t ret = do_read (buf, nbyte);
+      if (ret <= 0)
+        {
+          return ret;
+        }
+
+      // Scatter only what was actually read.
+      const char* q = buf;
+      std::size_t rest = static_cast<std::size_t> (ret);
+      for (int i = 0; i < iovcnt && rest > 0; ++i)
+        {
+          std::size_t n = std::min (iov[i].iov_len, rest);
+          std::memcpy (iov[i].iov_base, q, n);
+          q += n;
+          rest -= n;
+        }
+      return ret;
+#else
+      (void)iov;
+      (void)iovcnt;
+      (void)nbyte;
+      errno = ENOTSUP;
+      return -1;
+#endif
+    }
+
+    ssize_t
+    io_impl::bounce_writev (const iovec* iov, int iovcnt, std::size_t nbyte)
+    {
+#if MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE > 0
+      char buf[MICRO_OS_PLUS_INTEGER_POSIX_IO_IOVEC_BOUNCE_SIZE];
+      assert (nbyte <= sizeof (buf));
+
+      char* q = buf;
+      for (int i = 0; i < iovcnt; ++i)
+        {
+          std::memcpy (q, iov[i].iov_base, iov[i].iov_len);
+          q += iov[i].iov_len;
+        }
+
+      return do_write (buf, nbyte);
+#else
+      (void)iov;
+      (void)iovcnt;
+      (void)nbyte;
+      errno = ENOTSUP;
+      return -1;
+#endif
     }
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 
+    ssize_t
+    io_impl::do_pread (void* buf, std::size_t nbyte, off_t offset)
+    {
+      errno = ESPIPE; // Not seekable (sockets, pipes, char devices).
+      return -1;
+    }
+
+    ssize_t
+    io_impl::do_pwrite (const void* buf, std::size_t nbyte, off_t offset)
+    {
+      errno = ESPIPE; // Not seekable (sockets, pipes, char devices).
+      return -1;
+    }
+
+    int
+    io_impl::do_submit (io_request& request)
+    {
+      errno = ENOTSUP; // Synchronous only.
+      return -1;
+    }
+
     int
     io_impl::do_vfcntl (int cmd, std::va_list arguments)
     {
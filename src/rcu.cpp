@@ -0,0 +1,154 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <micro-os-plus/posix-io/rcu.h>
+#include <micro-os-plus/posix-io/io-waiter.h>
+
+#include <cerrno>
+#include <ctime>
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wc++98-compat"
+#endif
+
+namespace micro_os_plus
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    // Initialised to 0 by BSS, so usable by static constructors.
+    std::atomic<unsigned int> rcu::epoch__;
+    std::atomic<unsigned int> rcu::readers__[2];
+    std::atomic_flag rcu::writer__ = ATOMIC_FLAG_INIT;
+    std::atomic<bool> rcu::is_synchronizing__;
+
+    namespace
+    {
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#endif
+
+      // The writer sleeps here during a grace period. Static, so
+      // a late reader never wakes up a waiter already gone.
+      io_waiter grace_waiter__;
+
+#pragma GCC diagnostic pop
+    } // namespace
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    /**
+     * @details
+     * After the flip, new readers use the other counter, so the old
+     * one can only decrease; once zero, no reader can still hold a
+     * reference to a node removed before the call.
+     *
+     * The writer is flagged as waiting before checking the counter
+     * again, so the wake up from the last reader is not lost; the
+     * short timeout only covers a reader stepping back in its
+     * constructor, which does not wake up the writer.
+     */
+    void
+    rcu::synchronize (void)
+    {
+      unsigned int old = epoch__.fetch_add (1) & 1;
+      if (readers__[old].load () == 0)
+        {
+          return;
+        }
+
+      while (true)
+        {
+          grace_waiter__.arm ();
+          is_synchronizing__.store (true);
+          if (readers__[old].load () == 0)
+            {
+              break;
+            }
+          pause (grace_waiter__);
+        }
+
+      is_synchronizing__.store (false);
+    }
+
+    rcu::write_guard::write_guard (void)
+    {
+      if (!writer__.test_and_set (std::memory_order_acquire))
+        {
+          return;
+        }
+
+      // Writers are rare and short, sleep and retry.
+      io_waiter waiter;
+      do
+        {
+          waiter.arm ();
+          pause (waiter);
+        }
+      while (writer__.test_and_set (std::memory_order_acquire));
+    }
+
+    void
+    rcu::pause (io_waiter& waiter)
+    {
+      int saved_errno = errno;
+
+      // One millisecond, a few ticks at most.
+      timespec ts{ 0, 1000000 };
+      waiter.wait (&ts);
+
+      errno = saved_errno;
+    }
+
+    void
+    rcu::wakeup_writer (void)
+    {
+      grace_waiter__.wakeup ();
+    }
+
+    // ========================================================================
+  } // namespace posix
+} // namespace micro_os_plus
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
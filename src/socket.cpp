@@ -65,6 +65,21 @@ namespace micro_os_plus
 
     // ------------------------------------------------------------------------
 
+    int
+    socket::close (void)
+    {
+#if defined(MICRO_OS_PLUS_TRACE_POSIX_IO_SOCKET)
+      trace::printf ("socket::%s() @%p\n", __func__, this);
+#endif
+
+      int ret = io::close ();
+
+      // The object may be reused for a new connection.
+      impl ().is_listening_ = false;
+
+      return ret;
+    }
+
     class socket*
     socket::accept (sockaddr* address, socklen_t* address_len)
     {
@@ -133,7 +148,12 @@ namespace micro_os_plus
       errno = 0;
 
       // Execute the implementation specific code.
-      return impl ().do_listen (backlog);
+      int ret = impl ().do_listen (backlog);
+      if (ret == 0)
+        {
+          impl ().is_listening_ = true;
+        }
+      return ret;
     }
 
     ssize_t
@@ -236,6 +256,30 @@ namespace micro_os_plus
 #endif
     }
 
+    /**
+     * @details
+     * A closed socket reports a hang up. Otherwise report the
+     * events the network stack recorded with `notify_events()`;
+     * a listening socket is only readable, when a connection is
+     * pending, and a socket which is not connected cannot be
+     * written.
+     */
+    io::events_t
+    socket_impl::do_poll_events (void)
+    {
+      if (!do_is_opened ())
+        {
+          return io::event::hangup;
+        }
+
+      io::events_t events = pending_events ();
+      if (is_listening_ || !do_is_connected ())
+        {
+          return events & ~static_cast<io::events_t> (io::event::writable);
+        }
+      return events;
+    }
+
     // ==========================================================================
   } // namespace posix
 } // namespace micro_os_plus